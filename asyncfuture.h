@@ -7,7 +7,20 @@
 #include <QFutureWatcher>
 #include <QCoreApplication>
 #include <QMutex>
+#include <QAtomicInt>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QList>
+#include <QThreadStorage>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QExplicitlySharedDataPointer>
+#include <QPair>
 #include <functional>
+#include <tuple>
+#include <limits>
 
 #define ASYNCFUTURE_ERROR_OBSERVE_VOID_WITH_ARGUMENT "Observe a QFuture<void> but your callback contains an input argument"
 #define ASYNCFUTURE_ERROR_CALLBACK_NO_MORE_ONE_ARGUMENT "Callback function should not take more than 1 argument"
@@ -29,6 +42,68 @@ namespace AsyncFuture {
  * typename R - The return type of callback
  */
 
+/* ProgressCoalescing decides how often a progress value is passed on.
+ *
+ * A value that reaches the progress maximum is always passed on.
+ */
+class ProgressCoalescing {
+public:
+    enum Mode {
+        None,
+        Interval,
+        Delta,
+        EventLoopPass
+    };
+
+    ProgressCoalescing() : m_mode(None), m_amount(0) {
+    }
+
+    /// Pass on every progress value
+    static ProgressCoalescing none() {
+        return ProgressCoalescing();
+    }
+
+    /// Pass on at most one value per interval
+    static ProgressCoalescing interval(int msec) {
+        return ProgressCoalescing(Interval, msec);
+    }
+
+    /// Pass on a value only if it differs from the last one by minDelta or more
+    static ProgressCoalescing delta(int minDelta) {
+        return ProgressCoalescing(Delta, minDelta);
+    }
+
+    /// Pass on only the latest value once per pass of the event loop
+    static ProgressCoalescing eventLoopPass() {
+        return ProgressCoalescing(EventLoopPass, 0);
+    }
+
+    Mode mode() const {
+        return m_mode;
+    }
+
+    int amount() const {
+        return m_amount;
+    }
+
+private:
+    ProgressCoalescing(Mode mode, int amount) : m_mode(mode), m_amount(amount) {
+    }
+
+    Mode m_mode;
+    int m_amount;
+};
+
+/// What a signal stream does with an emission when its batch of the current event loop pass is full
+typedef enum {
+    // Drop the oldest emission of the batch
+    DropOldest,
+    // Drop the new emission
+    DropNewest,
+    // Report the batch right away
+    FlushBuffer
+} StreamOverflow;
+
 namespace Private {
 
 /* Begin traits functions */
@@ -130,6 +205,15 @@ struct decay_is_same :
     std::is_same<T, typename std::decay<U>::type>::type
 {};
 
+template <typename T>
+struct signal_arguments;
+
+template <typename... Args>
+struct signal_tuple_arguments;
+
+/* signal_traits gives the result type of observing a signal, and the arguments type that builds it
+ * from the argument array of qt_metacall.
+ */
 template <typename T>
 struct signal_traits {
     // Match class member function only
@@ -138,11 +222,24 @@ struct signal_traits {
 template <typename R, typename C>
 struct signal_traits<R (C::*)()> {
     typedef void result_type;
+    typedef signal_arguments<void> arguments;
 };
 
 template <typename R, typename C, typename ARG0>
 struct signal_traits<R (C::*)(ARG0)> {
     typedef typename std::decay<ARG0>::type result_type;
+    typedef signal_arguments<result_type> arguments;
+};
+
+// A signal with more than one argument is observed as a std::tuple
+template <typename R, typename C, typename ARG0, typename ARG1, typename... ARGS>
+struct signal_traits<R (C::*)(ARG0, ARG1, ARGS...)> {
+    typedef std::tuple<typename std::decay<ARG0>::type,
+                       typename std::decay<ARG1>::type,
+                       typename std::decay<ARGS>::type...> result_type;
+    typedef signal_tuple_arguments<typename std::decay<ARG0>::type,
+                                   typename std::decay<ARG1>::type,
+                                   typename std::decay<ARGS>::type...> arguments;
 };
 
 template <typename T>
@@ -294,7 +391,7 @@ public:
     Value() {
     }
 
-    Value(R&& v) : value(v){
+    Value(R&& v) : value(std::move(v)){
     }
 
     Value(R* v) : value(*v) {
@@ -322,243 +419,1228 @@ public:
     }
 };
 
+template <int... I>
+struct index_list {
+};
+
+template <int N, int... I>
+struct make_index_list : make_index_list<N - 1, N - 1, I...> {
+};
+
+template <int... I>
+struct make_index_list<0, I...> {
+    typedef index_list<I...> type;
+};
+
+/// Build the value of a signal from the argument array of qt_metacall. a[0] is the return value.
+template <typename T>
+struct signal_arguments {
+    static Value<T> value(void** a) {
+        return Value<T>(reinterpret_cast<T*>(a[1]));
+    }
+};
+
+template <>
+struct signal_arguments<void> {
+    static Value<void> value(void** a) {
+        Q_UNUSED(a);
+        return Value<void>((void*) 0);
+    }
+};
+
+/// Build a std::tuple from the arguments directly, without QVariant.
+template <typename... Args>
+struct signal_tuple_arguments {
+    static Value<std::tuple<Args...>> value(void** a) {
+        return build(a, typename make_index_list<sizeof...(Args)>::type());
+    }
+
+    template <int... I>
+    static Value<std::tuple<Args...>> build(void** a, index_list<I...>) {
+        return Value<std::tuple<Args...>>(std::tuple<Args...>(*reinterpret_cast<Args*>(a[I + 1])...));
+    }
+};
+
+/// Post the function to the thread of the target object. It is always executed asynchronously.
 template <typename F>
-void runInMainThread(F func) {
+void runInThread(const QObject* target, F func) {
+#if QT_VERSION < QT_VERSION_CHECK(5, 10, 0)
     QObject tmp;
     QObject::connect(&tmp, &QObject::destroyed,
-                     QCoreApplication::instance(), std::move(func), Qt::QueuedConnection);
+                     target, std::move(func), Qt::QueuedConnection);
+#else
+    QMetaObject::invokeMethod(const_cast<QObject*>(target), std::move(func), Qt::QueuedConnection);
+#endif
 }
 
-/*
- * @param owner If the object is destroyed, it should destroy the watcher
- * @param contextObject Determine the receiver callback
+template <typename F>
+void runInMainThread(F func) {
+    runInThread(QCoreApplication::instance(), std::move(func));
+}
+
+/// Delete the object now if it lives in the calling thread. Otherwise, it is deleted by its own thread.
+inline void deleteInThread(QObject* object) {
+    if (object->thread() == QThread::currentThread()) {
+        delete object;
+    } else {
+        object->deleteLater();
+    }
+}
+
+/* Dispatcher is the receiver of the callbacks that have no context object.
+ *
+ * The main thread and the threads running an event loop dispatch their own callbacks.
+ * Other worker threads share a background thread, so that a chain built and completed
+ * on worker threads never waits for a busy main thread.
  */
+class Dispatcher : public QObject {
+public:
+    /// The dispatcher for the calling thread
+    static const QObject* current() {
+        QThread* thread = QThread::currentThread();
 
-template <typename T, typename Finished, typename Canceled, typename Progress, typename ProgressRange>
-void watch(QFuture<T> future,
-		   const QObject* owner,
-		   const QObject* contextObject,
-           Finished finished,
-           Canceled canceled,
-           Progress progress,
-           ProgressRange progressRange) {
+        if (thread == QCoreApplication::instance()->thread()) {
+            return QCoreApplication::instance();
+        }
 
-    Q_ASSERT(owner);
-	QPointer<const QObject> ownerAlive = owner;
+        if (hasEventLoop(thread)) {
+            return local();
+        }
 
-    QPointer<QFutureWatcher<T>> watcher(new QFutureWatcher<T>());
+        return background();
+    }
 
-    if (owner) {
-        // Don't set parent as the context object as it may live in different thread
-        QObject::connect(owner, &QObject::destroyed,
-                         watcher, [watcher]() {
-            delete watcher;
-        });
+    /// One of the shard dispatchers. Each of them runs in its own background thread.
+    static const QObject* shard(int index) {
+        static QVector<Dispatcher*> dispatchers = createShards();
+        return dispatchers[index % dispatchers.size()];
     }
 
-    if (contextObject) {
+    /// Move the object to the main thread once its thread is finished, so that the events posted to it are still delivered.
+    /** The main thread and the background dispatchers run until the application quits, so it is only needed in other threads.
+     */
+    static void adopt(QObject* object) {
+        QThread* thread = object->thread();
 
-        QObject::connect(watcher, &QFutureWatcher<T>::finished,
-                         contextObject, [=]() {
-            bool watcherCancelled = true;
-            if(!watcher.isNull()) {
-                watcherCancelled = watcher->isCanceled();
-                delete watcher;
-            } else {
-                return;
-            }
+        if (thread == QCoreApplication::instance()->thread() || dynamic_cast<BackgroundThread*>(thread)) {
+            return;
+        }
 
-            if (ownerAlive.isNull()) {
-                return;
+        QObject::connect(thread, &QThread::finished, object, [object]() {
+            // It is emitted by the finishing thread, while it still owns the object
+            if (object->thread() == QThread::currentThread()) {
+                object->moveToThread(QCoreApplication::instance()->thread());
             }
+        }, Qt::DirectConnection);
+    }
 
-            if(!watcherCancelled) {
-                finished();
-            } else {
-                canceled();
-            }
-        });
+private:
+    class BackgroundThread : public QThread {
+    };
 
-        QObject::connect(watcher, &QFutureWatcher<T>::canceled,
-                         contextObject, [=]() {
-            if(!watcher.isNull()) {
-                delete watcher;
-            } else {
-                return;
-            }
-            if (ownerAlive.isNull()) {
-                return;
-            }
-            canceled();
-        });
+    static bool hasEventLoop(QThread* thread) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
+        return thread->loopLevel() > 0;
+#else
+        Q_UNUSED(thread);
+        return false;
+#endif
+    }
 
+    /* The dispatcher of a thread running an event loop.
+     *
+     * It is not owned by the thread storage, as deleting it would drop the callbacks posted to it.
+     * Once the thread is finished, it is moved to the main thread together with its posted events,
+     * and deleted after they are delivered.
+     */
+    static const QObject* local() {
+        static QThreadStorage<QPointer<Dispatcher>>* storage = new QThreadStorage<QPointer<Dispatcher>>();
 
-        QObject::connect(watcher, &QFutureWatcher<T>::progressValueChanged,
-                         contextObject, [=](int value) {
-            progress(value);
-        });
+        if (!storage->hasLocalData()) {
+            Dispatcher* dispatcher = new Dispatcher();
 
-        QObject::connect(watcher, &QFutureWatcher<T>::progressRangeChanged,
-                         contextObject, [=](int min, int max) {
-            progressRange(min, max);
-        });
+            QObject::connect(QThread::currentThread(), &QThread::finished, dispatcher, [dispatcher]() {
+                dispatcher->moveToThread(QCoreApplication::instance()->thread());
+                dispatcher->deleteLater();
+            }, Qt::DirectConnection);
 
+            storage->setLocalData(dispatcher);
+        }
+        return storage->localData().data();
+    }
 
-    } else {
-        QObject::connect(watcher, &QFutureWatcher<T>::finished,
-                         [=]() {
-            if(!watcher.isNull()) {
-                delete watcher;
-            }
-            if (ownerAlive.isNull()) {
-                return;
-            }
-            finished();
-        });
+    static const QObject* background() {
+        static Dispatcher* dispatcher = createBackground("AsyncFuture Dispatcher");
+        return dispatcher;
+    }
 
-        QObject::connect(watcher, &QFutureWatcher<T>::canceled,
-                         [=]() {
-            if(!watcher.isNull()) {
-                delete watcher;
-            }
-            if (ownerAlive.isNull()) {
-                return;
-            }
-            canceled();
-        });
+    static QVector<Dispatcher*> createShards() {
+        QVector<Dispatcher*> dispatchers;
+        int count = qMax(2, QThread::idealThreadCount());
+        for (int i = 0 ; i < count ; i++) {
+            dispatchers << createBackground(QString("AsyncFuture Dispatcher Shard %1").arg(i));
+        }
+        return dispatchers;
+    }
 
+    static Dispatcher* createBackground(const QString& name) {
+        QThread* thread = new BackgroundThread();
+        thread->setObjectName(name);
 
-        QObject::connect(watcher, &QFutureWatcher<T>::progressValueChanged,
-                         [=](int value) {
-            progress(value);
-        });
+        Dispatcher* dispatcher = new Dispatcher();
+        dispatcher->moveToThread(thread);
+        thread->moveToThread(QCoreApplication::instance()->thread());
 
-        QObject::connect(watcher, &QFutureWatcher<T>::progressRangeChanged,
-                         [=](int min, int max) {
-            progressRange(min, max);
+        QObject::connect(QCoreApplication::instance(), &QObject::destroyed, [thread]() {
+            thread->quit();
+            thread->wait();
         });
 
+        thread->start();
+        return dispatcher;
     }
+};
 
-    if ((QThread::currentThread() != QCoreApplication::instance()->thread()) &&
-         (contextObject == 0 || QThread::currentThread() != contextObject->thread())) {
-        // Move watcher to main thread if context object is not set.
-        watcher->moveToThread(QCoreApplication::instance()->thread());
+/// ProgressScale fits 64-bit progress into the int range of QFutureInterface.
+/** The values are passed as they are while the maximum fits. Otherwise they are scaled down to [0, INT_MAX].
+ */
+class ProgressScale {
+public:
+    static int maximum(qint64 max) {
+        return max > limit() ? limit() : int(max);
     }
 
-    watcher->setFuture(future);
-}
+    static int value(qint64 value, qint64 max) {
+        if (max <= limit()) {
+            return int(value);
+        }
+        return int(double(value) * limit() / double(max));
+    }
 
-/* DeferredFuture implements a QFutureInterface that could complete/cancel a QFuture.
- *
- * 1) It is a private class that won't export to public
- *
- * 2) Its member function do not use <T> to avoid to use template specialization to handle <void>. Type checking should be done by user classes (e.g Deferred)
- *
- */
+private:
+    static qint64 limit() {
+        return std::numeric_limits<int>::max();
+    }
+};
 
-template <typename T>
-class DeferredFuture : public QObject, public QFutureInterface<T>{
+/// ProgressGate applies a ProgressCoalescing to a stream of progress values. It could be used from any thread.
+class ProgressGate {
 public:
+    ProgressGate() : mode(ProgressCoalescing::None), amount(0), lastValue(0), scheduled(false), pending(false),
+                     pendingValue(0) {
+    }
 
-    ~DeferredFuture() {
-        cancel();
+    void setCoalescing(ProgressCoalescing coalescing) {
+        QMutexLocker locker(&mutex);
+        amount = coalescing.amount();
+        lastValue = 0;
+        pending = false;
+        elapsed.invalidate();
+        mode.storeRelease(coalescing.mode());
     }
 
-    template <typename ANY>
-    void track(QFuture<ANY> future) {
-        QPointer<DeferredFuture<T>> thiz = this;
-        QFutureWatcher<ANY> *watcher = new QFutureWatcher<ANY>();
+    /// Return true if the value should be passed on now.
+    /** In EventLoopPass mode, the first value of a pass posts the flush function to the receiver
+     *  and the others are merged into it. In Interval mode, the first value held back within an interval
+     *  arms a timer on the receiver's thread that calls the flush function once the interval is over.
+     *  The flush function should pass on the value taken by flushed(), if any.
+     *
+     *  In every mode, the latest value held back is kept until it is taken by flushed() or takePending().
+     */
+    template <typename F>
+    bool pass(int value, int maximum, const QObject* receiver, F flush) {
+        int currentMode = mode.loadAcquire();
 
-        if ((QThread::currentThread() != QCoreApplication::instance()->thread())) {
-            watcher->moveToThread(QCoreApplication::instance()->thread());
+        if (currentMode == ProgressCoalescing::None) {
+            return true;
         }
 
-        QObject::connect(watcher, &QFutureWatcher<ANY>::finished, [=]() {
-            watcher->disconnect();
-            watcher->deleteLater();
-        });
+        QMutexLocker locker(&mutex);
 
-        QObject::connect(watcher, &QFutureWatcher<ANY>::progressValueChanged, this, [=](int value) {
-            if (thiz.isNull()) {
-                return;
-            }
-            thiz->setWatchProgressValue(value);
-        });
+        if (maximum > 0 && value >= maximum) {
+            lastValue = value;
+            pending = false;
+            return true;
+        }
 
-        QObject::connect(watcher, &QFutureWatcher<ANY>::progressRangeChanged, this, [=](int min, int max) {
-            if (thiz.isNull()) {
-                return;
+        switch (currentMode) {
+        case ProgressCoalescing::Interval:
+            if (elapsed.isValid() && elapsed.elapsed() < amount) {
+                holdBack(value);
+                if (!scheduled) {
+                    scheduled = true;
+                    int remaining = int(amount - elapsed.elapsed());
+                    runInThread(receiver, [=]() mutable {
+                        QTimer::singleShot(remaining, receiver, std::move(flush));
+                    });
+                }
+                return false;
             }
-            thiz->setWatchProgressRange(min, max);
-        });
+            elapsed.start();
+            pending = false;
+            return true;
+        case ProgressCoalescing::Delta:
+            if (qAbs(value - lastValue) < amount) {
+                holdBack(value);
+                return false;
+            }
+            lastValue = value;
+            pending = false;
+            return true;
+        default:
+            holdBack(value);
+            if (!scheduled) {
+                scheduled = true;
+                runInThread(receiver, std::move(flush));
+            }
+            return false;
+        }
+    }
 
-        QObject::connect(watcher, &QFutureWatcher<ANY>::started, this, [=](){
-            thiz->reportStarted();
-        });
+    /// Called by the flush function. Return true and take the value held back, if it is not taken yet.
+    bool flushed(int* value) {
+        QMutexLocker locker(&mutex);
+        scheduled = false;
+        if (!pending) {
+            return false;
+        }
+        if (mode.loadAcquire() == ProgressCoalescing::Interval) {
+            elapsed.start();
+        }
+        return take(value);
+    }
 
-        QObject::connect(watcher, &QFutureWatcher<ANY>::paused, this, [=](){
-            thiz->setPaused(true);
-        });
+    /// Return true and take the value held back, if any. It is called before the future is finished.
+    bool takePending(int* value) {
+        QMutexLocker locker(&mutex);
+        return take(value);
+    }
 
-        QObject::connect(watcher, &QFutureWatcher<ANY>::resumed, this, [=](){
-            thiz->setPaused(false);
-        });
+private:
+    QMutex mutex;
+    QAtomicInt mode;
+    int amount;
+    int lastValue;
+    bool scheduled;
+
+    // The latest value held back and not passed on yet
+    bool pending;
+    int pendingValue;
+    QElapsedTimer elapsed;
+
+    void holdBack(int value) {
+        pending = true;
+        pendingValue = value;
+    }
 
-        watcher->setFuture(future);
+    bool take(int* value) {
+        if (!pending) {
+            return false;
+        }
+        pending = false;
+        lastValue = pendingValue;
+        *value = pendingValue;
+        return true;
+    }
+};
 
-        setWatchProgressRange(future.progressMinimum(), future.progressMaximum());
-        setWatchProgressValue(future.progressValue());
+/* ObjectPool recycles the memory of the objects created per step of a chain.
+ *
+ * Each thread owns an arena with a freelist per size class. A block released by
+ * another thread is pushed to the remote stack of its owner arena, and the owner
+ * takes them back when its freelist is empty. An arena is never destroyed. It is
+ * handed over to the next new thread once its thread is finished.
+ */
+class ObjectPool {
+public:
+    class Statistics {
+    public:
+        /// No. of blocks allocated from the global heap
+        int heapAllocations;
 
-        if (future.isStarted()) {
-            QFutureInterface<T>::reportStarted();
-        }
+        /// No. of allocations served by a freelist
+        int pooledAllocations;
 
-        if (future.isPaused()) {
-            QFutureInterface<T>::setPaused(true);
+        /// No. of blocks released by a thread other than the owner
+        int remoteReleases;
+
+        /// No. of blocks returned to the global heap
+        int heapReleases;
+
+        /// No. of free blocks kept by the pool
+        int cached;
+
+        /// No. of arenas. It is the peak no. of threads using the pool
+        int arenas;
+    };
+
+    static void* allocate(size_t size) {
+        int sizeClass = int((size + Granularity - 1) / Granularity) - 1;
+
+        if (sizeClass >= ClassCount) {
+            currentArena()->heapAllocations.ref();
+            Header* header = static_cast<Header*>(::operator new(HeaderSize + size));
+            header->owner = nullptr;
+            header->sizeClass = -1;
+            return reinterpret_cast<char*>(header) + HeaderSize;
         }
-    }
 
-    bool isFinished() const {
-        return QFutureInterface<T>::isFinished();
-    }
+        Arena* arena = currentArena();
+        Block* block = arena->take(sizeClass);
 
-    // complete<void>()
-    void complete() {
-        if (isFinished()) {
-            return;
+        if (block) {
+            arena->pooledAllocations.ref();
+            arena->cached.deref();
+        } else {
+            arena->heapAllocations.ref();
+            block = static_cast<Block*>(::operator new(HeaderSize + (sizeClass + 1) * Granularity));
+            block->header.owner = arena;
+            block->header.sizeClass = sizeClass;
         }
-        QFutureInterface<T>::reportFinished();
+        return reinterpret_cast<char*>(block) + HeaderSize;
     }
 
-    template <typename R>
-    void complete(R value) {
-        if (isFinished()) {
+    static void release(void* ptr) {
+        if (!ptr) {
             return;
         }
-        reportResult(value);
-        QFutureInterface<T>::reportFinished();
-    }
 
-    template <typename R>
-    void complete(QList<R>& value) {
-        if (isFinished()) {
+        Block* block = reinterpret_cast<Block*>(static_cast<char*>(ptr) - HeaderSize);
+        Arena* owner = block->header.owner;
+
+        Arena* current = currentArena();
+
+        if (!owner) {
+            current->heapReleases.ref();
+            ::operator delete(block);
             return;
         }
 
-        reportResult(value);
-        QFutureInterface<T>::reportFinished();
+        if (owner == current) {
+            owner->put(block);
+        } else {
+            current->remoteReleases.ref();
+            owner->pushRemote(block);
+        }
     }
 
-    template <typename R>
-    void complete(Value<R> value) {
-        this->complete(value.value);
+    /// Sum up the counters of all the arenas. The values are a snapshot, as the other threads keep updating them.
+    static Statistics statistics() {
+        Registry* reg = registry();
+        Statistics stat;
+        stat.heapAllocations = 0;
+        stat.pooledAllocations = 0;
+        stat.remoteReleases = 0;
+        stat.heapReleases = 0;
+        stat.cached = 0;
+
+        QMutexLocker locker(&reg->mutex);
+        for (const Arena* arena : reg->arenas) {
+            stat.heapAllocations += arena->heapAllocations.loadAcquire();
+            stat.pooledAllocations += arena->pooledAllocations.loadAcquire();
+            stat.remoteReleases += arena->remoteReleases.loadAcquire();
+            stat.heapReleases += arena->heapReleases.loadAcquire();
+            stat.cached += arena->cached.loadAcquire();
+        }
+        stat.arenas = reg->arenas.size();
+        return stat;
     }
 
-    void complete(Value<void> value) {
-        Q_UNUSED(value);
-        this->complete();
-    }
+private:
+    enum {
+        Granularity = 16,
+        ClassCount = 32,
+        // The max. no. of free blocks kept per size class and thread
+        FreeListLimit = 1024,
+        // Keep the memory returned to the user aligned
+        HeaderSize = 16
+    };
+
+    class Arena;
+
+    class Header {
+    public:
+        Arena* owner;
+        int sizeClass;
+    };
+
+    class Block {
+    public:
+        Header header;
+        // Only valid while the block is free. It is stored in the user memory.
+        Block* next;
+    };
+
+    class Registry {
+    public:
+        QMutex mutex;
+        QList<Arena*> orphans;
+        // All the arenas ever created, for statistics()
+        QList<Arena*> arenas;
+    };
+
+    class Arena {
+    public:
+        Arena() {
+            for (int i = 0 ; i < ClassCount ; i++) {
+                freeList[i] = nullptr;
+                freeCount[i] = 0;
+            }
+        }
+
+        /* The statistics of the thread using this arena. Only that thread updates them, so the threads
+         * don't write the same cache lines on the hot path. statistics() sums them up.
+         */
+        QAtomicInt heapAllocations;
+        QAtomicInt pooledAllocations;
+        QAtomicInt remoteReleases;
+        QAtomicInt heapReleases;
+        QAtomicInt cached;
+
+        Block* take(int sizeClass) {
+            if (!freeList[sizeClass]) {
+                drainRemote();
+            }
+
+            Block* block = freeList[sizeClass];
+            if (block) {
+                freeList[sizeClass] = block->next;
+                freeCount[sizeClass]--;
+            }
+            return block;
+        }
+
+        void put(Block* block) {
+            int sizeClass = block->header.sizeClass;
+
+            if (freeCount[sizeClass] >= FreeListLimit) {
+                heapReleases.ref();
+                ::operator delete(block);
+                return;
+            }
+
+            block->next = freeList[sizeClass];
+            freeList[sizeClass] = block;
+            freeCount[sizeClass]++;
+            cached.ref();
+        }
+
+        void pushRemote(Block* block) {
+            Block* head = remote.loadAcquire();
+            do {
+                block->next = head;
+            } while (!remote.testAndSetOrdered(head, block, head));
+        }
+
+    private:
+        void drainRemote() {
+            // Take the whole stack at once. It is free from the ABA problem.
+            Block* block = remote.fetchAndStoreAcquire(nullptr);
+
+            while (block) {
+                Block* next = block->next;
+                put(block);
+                block = next;
+            }
+        }
+
+        Block* freeList[ClassCount];
+        int freeCount[ClassCount];
+        QAtomicPointer<Block> remote;
+    };
+
+    // Hand over the arena to the orphan list on thread exit
+    class ArenaHolder {
+    public:
+        ArenaHolder(Arena* arena) : arena(arena) {
+        }
+
+        ~ArenaHolder() {
+            Registry* reg = registry();
+            QMutexLocker locker(&reg->mutex);
+            reg->orphans.append(arena);
+        }
+
+        Arena* arena;
+    };
+
+    static Registry* registry() {
+        // It is never destroyed. A block could be released after static destruction.
+        static Registry* instance = new Registry();
+        return instance;
+    }
+
+    static Arena* currentArena() {
+        static QThreadStorage<ArenaHolder*>* storage = new QThreadStorage<ArenaHolder*>();
+
+        if (storage->hasLocalData()) {
+            return storage->localData()->arena;
+        }
+
+        Registry* reg = registry();
+        Arena* arena = nullptr;
+
+        reg->mutex.lock();
+        if (!reg->orphans.isEmpty()) {
+            arena = reg->orphans.takeLast();
+        }
+        reg->mutex.unlock();
+
+        if (!arena) {
+            arena = new Arena();
+            reg->mutex.lock();
+            reg->arenas.append(arena);
+            reg->mutex.unlock();
+        }
+
+        storage->setLocalData(new ArenaHolder(arena));
+        return arena;
+    }
+};
+
+/// Allocate the memory of derived classes from ObjectPool
+class Pooled {
+public:
+    static void* operator new(size_t size) {
+        return ObjectPool::allocate(size);
+    }
+
+    static void operator delete(void* ptr) {
+        ObjectPool::release(ptr);
+    }
+};
+
+/* Continuation is a node of the intrusive list of callbacks waiting for a future.
+ *
+ * It is owned by the ContinuationList that it is appended to, and it is released right after settle().
+ */
+class Continuation : public Pooled {
+public:
+    Continuation() : next(nullptr) {
+    }
+
+    virtual ~Continuation() {
+    }
+
+    virtual void settle(bool canceled) = 0;
+
+    /// Called by the ContinuationList that no longer holds this continuation
+    virtual void release() {
+        delete this;
+    }
+
+    virtual void progressValueChanged(int value) = 0;
+
+    virtual void progressRangeChanged(int min, int max) = 0;
+
+    Continuation* next;
+};
+
+/* ContinuationList runs its continuations once the observed future is finished or canceled.
+ *
+ * A continuation appended after that is settled immediately.
+ */
+class ContinuationList : public Pooled {
+public:
+    ContinuationList() : head(nullptr), tail(nullptr), settled(false), settledAsCanceled(false) {
+    }
+
+    virtual ~ContinuationList() {
+        release(head);
+    }
+
+    void append(Continuation* continuation) {
+        listMutex.lock();
+
+        if (settled) {
+            bool canceled = settledAsCanceled;
+            listMutex.unlock();
+            release(continuation, canceled);
+            return;
+        }
+
+        if (tail) {
+            tail->next = continuation;
+        } else {
+            head = continuation;
+        }
+        tail = continuation;
+        listMutex.unlock();
+    }
+
+    void settle(bool canceled) {
+        listMutex.lock();
+
+        if (settled) {
+            listMutex.unlock();
+            return;
+        }
+
+        settled = true;
+        settledAsCanceled = canceled;
+        Continuation* first = head;
+        head = tail = nullptr;
+        listMutex.unlock();
+
+        release(first, canceled);
+        onSettled();
+    }
+
+    void notifyProgressValue(int value) {
+        QMutexLocker locker(&listMutex);
+        for (Continuation* continuation = head; continuation; continuation = continuation->next) {
+            continuation->progressValueChanged(value);
+        }
+    }
+
+    void notifyProgressRange(int min, int max) {
+        QMutexLocker locker(&listMutex);
+        for (Continuation* continuation = head; continuation; continuation = continuation->next) {
+            continuation->progressRangeChanged(min, max);
+        }
+    }
+
+    /// It is called once the future is handed out, so that it could be canceled by QFuture::cancel()
+    virtual void prepare() {
+    }
+
+    /// Keep this list alive until unretain(). It is called with the registry lock held.
+    /** It fails if the list is about to be destroyed.
+     */
+    virtual bool retain() = 0;
+
+    virtual void unretain() = 0;
+
+protected:
+    /// It is called once after all the continuations are settled
+    virtual void onSettled() {
+    }
+
+private:
+    QMutex listMutex;
+    Continuation* head;
+    Continuation* tail;
+    bool settled;
+    bool settledAsCanceled;
+
+    static void release(Continuation* continuation) {
+        while (continuation) {
+            Continuation* next = continuation->next;
+            continuation->release();
+            continuation = next;
+        }
+    }
+
+    static void release(Continuation* continuation, bool canceled) {
+        while (continuation) {
+            Continuation* next = continuation->next;
+            continuation->settle(canceled);
+            continuation->release();
+            continuation = next;
+        }
+    }
+};
+
+/// Connect a QFutureWatcher to a ContinuationList
+template <typename T>
+void forward(QFutureWatcher<T>* watcher, ContinuationList* list) {
+    QObject::connect(watcher, &QFutureWatcher<T>::finished, watcher, [=]() {
+        list->settle(watcher->isCanceled());
+    });
+
+    QObject::connect(watcher, &QFutureWatcher<T>::canceled, watcher, [=]() {
+        list->settle(true);
+    });
+
+    QObject::connect(watcher, &QFutureWatcher<T>::progressValueChanged, watcher, [=](int value) {
+        list->notifyProgressValue(value);
+    });
+
+    QObject::connect(watcher, &QFutureWatcher<T>::progressRangeChanged, watcher, [=](int min, int max) {
+        list->notifyProgressRange(min, max);
+    });
+}
+
+/// The result store is shared by all the copies of a future. Its address identifies the future.
+template <typename T>
+const void* futureKey(const QFuture<T>& future) {
+    return &future.d.resultStoreBase();
+}
+
+/* ContinuationRegistry finds the ContinuationList of a future.
+ *
+ * A DeferredFuture registers itself. Any other future is observed by a SharedWatcher per thread.
+ * It is sharded by the key of the future, so the futures created and observed by different threads
+ * rarely wait for the same lock.
+ */
+class ContinuationRegistry {
+public:
+    QMutex mutex;
+    QHash<const void*, ContinuationList*> deferreds;
+    QHash<QPair<const void*, QThread*>, ContinuationList*> watchers;
+
+    static ContinuationRegistry* of(const void* key) {
+        static ContinuationRegistry shards[ShardCount];
+        return &shards[qHash(key) % ShardCount];
+    }
+
+private:
+    enum {
+        ShardCount = 64
+    };
+};
+
+/// SharedWatcher is the only QFutureWatcher created for a plain QFuture (e.g QtConcurrent::run) in a thread.
+template <typename T>
+class SharedWatcher : public QFutureWatcher<T>, public ContinuationList {
+public:
+    SharedWatcher(QFuture<T> future, QThread* thread) : key(qMakePair(futureKey(future), thread)), refs(1) {
+        forward<T>(this, this);
+
+        if (thread != QThread::currentThread()) {
+            this->moveToThread(thread);
+        }
+
+        Dispatcher::adopt(this);
+
+        this->setFuture(future);
+    }
+
+    QPair<const void*, QThread*> key;
+
+    bool retain() {
+        refs.ref();
+        return true;
+    }
+
+    void unretain() {
+        if (!refs.deref()) {
+            this->deleteLater();
+        }
+    }
+
+protected:
+    void onSettled() {
+        ContinuationRegistry* registry = ContinuationRegistry::of(key.first);
+        registry->mutex.lock();
+        registry->watchers.remove(key);
+        registry->mutex.unlock();
+
+        unretain();
+    }
+
+private:
+    // One is held until it is settled, as it could be found in the registry till then
+    QAtomicInt refs;
+};
+
+/// Append a continuation to the ContinuationList of the future
+template <typename T>
+void observeFuture(QFuture<T> future, const QObject* contextObject, Continuation* continuation) {
+    const void* key = futureKey(future);
+    ContinuationRegistry* registry = ContinuationRegistry::of(key);
+
+    registry->mutex.lock();
+
+    ContinuationList* list = registry->deferreds.value(key, nullptr);
+
+    if (list && !list->retain()) {
+        // The DeferredFuture is being destroyed. Its future is watched as a plain one.
+        list = nullptr;
+    }
+
+    if (!list) {
+        // The watcher lives in the thread of the context object, so its callbacks are delivered without another hop.
+        // e.g. The futures of a shard are watched by the shard dispatcher, not by the thread that added them.
+        QThread* thread = contextObject ? contextObject->thread() : Dispatcher::current()->thread();
+
+        list = registry->watchers.value(qMakePair(key, thread), nullptr);
+
+        if (!list) {
+            list = new SharedWatcher<T>(future, thread);
+            registry->watchers.insert(qMakePair(key, thread), list);
+        }
+
+        list->retain();
+    }
+
+    registry->mutex.unlock();
+
+    // The continuation is settled immediately if the future is finished already. It may observe
+    // another future, so it must not run with the registry lock held.
+    list->append(continuation);
+    list->unretain();
+}
+
+/// Find the ContinuationList of a DeferredFuture. It is retained, the caller should unretain() it.
+inline ContinuationList* retainDeferred(const void* key) {
+    ContinuationRegistry* registry = ContinuationRegistry::of(key);
+
+    registry->mutex.lock();
+    ContinuationList* list = registry->deferreds.value(key, nullptr);
+    if (list && !list->retain()) {
+        list = nullptr;
+    }
+    registry->mutex.unlock();
+
+    return list;
+}
+
+/// Prepare a future to be handed out. A DeferredFuture starts watching the cancellation made by QFuture::cancel().
+template <typename T>
+void exposeFuture(const QFuture<T>& future) {
+    ContinuationList* list = retainDeferred(futureKey(future));
+
+    if (list) {
+        list->prepare();
+        list->unretain();
+    }
+}
+
+/// Cancel a future. The continuations of a DeferredFuture are settled directly, as it is not watched unless it is handed out.
+template <typename T>
+void cancelFuture(QFuture<T> future) {
+    future.cancel();
+
+    ContinuationList* list = retainDeferred(futureKey(future));
+
+    if (list) {
+        list->settle(true);
+        list->unretain();
+    }
+}
+
+template <typename Finished, typename Canceled, typename Progress, typename ProgressRange>
+class CallbackContinuation : public Continuation {
+public:
+    CallbackContinuation(const QObject* owner,
+                         const QObject* contextObject,
+                         Finished finished,
+                         Canceled canceled,
+                         Progress progress,
+                         ProgressRange progressRange) :
+        owner(owner),
+        contextObject(contextObject),
+        finished(finished),
+        canceled(canceled),
+        progress(progress),
+        progressRange(progressRange) {
+    }
+
+    void settle(bool isCanceled) {
+        if (owner.isNull()) {
+            return;
+        }
+
+        // A context object left in a finished thread would never deliver the callback, so the main thread runs it.
+        // The dispatcher of a thread doesn't need it, as it moves to the main thread together with its posted events.
+        const QObject* receiver = contextObject.data();
+        if (receiver == nullptr || receiver->thread()->isFinished()) {
+            receiver = QCoreApplication::instance();
+        }
+
+        QPointer<const QObject> ownerAlive = owner;
+        Finished onFinished = finished;
+        Canceled onCanceled = canceled;
+
+        runInThread(receiver, [=]() {
+            if (ownerAlive.isNull()) {
+                return;
+            }
+
+            if (!isCanceled) {
+                onFinished();
+            } else {
+                onCanceled();
+            }
+        });
+    }
+
+    void progressValueChanged(int value) {
+        if (!owner.isNull()) {
+            progress(value);
+        }
+    }
+
+    void progressRangeChanged(int min, int max) {
+        if (!owner.isNull()) {
+            progressRange(min, max);
+        }
+    }
+
+private:
+    QPointer<const QObject> owner;
+    QPointer<const QObject> contextObject;
+    Finished finished;
+    Canceled canceled;
+    Progress progress;
+    ProgressRange progressRange;
+};
+
+/*
+ * @param owner If the object is destroyed, the callbacks will not be executed
+ * @param contextObject Determine the receiver callback. If it is null, the callback will be executed by the dispatcher of the calling thread.
+ */
+
+template <typename T, typename Finished, typename Canceled, typename Progress, typename ProgressRange>
+void watch(QFuture<T> future,
+		   const QObject* owner,
+		   const QObject* contextObject,
+           Finished finished,
+           Canceled canceled,
+           Progress progress,
+           ProgressRange progressRange) {
+
+    Q_ASSERT(owner);
+
+    const QObject* receiver = contextObject ? contextObject : Dispatcher::current();
+
+    auto continuation = new CallbackContinuation<Finished, Canceled, Progress, ProgressRange>(
+                owner,
+                receiver,
+                finished,
+                canceled,
+                progress,
+                progressRange);
+
+    observeFuture(future, receiver, continuation);
+}
+
+/* DeferredPointer is a smart pointer to a DeferredFuture.
+ *
+ * Each instance holds a reference of the DeferredFuture, the same kind as the one held by a pending
+ * callback that could complete it. Unlike QSharedPointer, it doesn't need to allocate a control block.
+ */
+template <typename T>
+class DeferredPointer {
+public:
+    DeferredPointer() : object(nullptr) {
+    }
+
+    explicit DeferredPointer(T* object) : object(object) {
+        acquire();
+    }
+
+    DeferredPointer(const DeferredPointer& other) : object(other.object) {
+        acquire();
+    }
+
+    DeferredPointer(DeferredPointer&& other) : object(other.object) {
+        other.object = nullptr;
+    }
+
+    ~DeferredPointer() {
+        clear();
+    }
+
+    DeferredPointer& operator=(DeferredPointer other) {
+        std::swap(object, other.object);
+        return *this;
+    }
+
+    T* operator->() const {
+        return object;
+    }
+
+    T& operator*() const {
+        return *object;
+    }
+
+    T* data() const {
+        return object;
+    }
+
+    bool isNull() const {
+        return object == nullptr;
+    }
+
+    void clear() {
+        T* ptr = object;
+        object = nullptr;
+
+        if (ptr) {
+            ptr->decWeakRefCount();
+        }
+    }
+
+private:
+    void acquire() {
+        if (object) {
+            object->incWeakRefCount();
+        }
+    }
+
+    T* object;
+};
+
+/* DeferredFuture implements a QFutureInterface that could complete/cancel a QFuture.
+ *
+ * 1) It is a private class that won't export to public
+ *
+ * 2) Its member function do not use <T> to avoid to use template specialization to handle <void>. Type checking should be done by user classes (e.g Deferred)
+ *
+ * 3) It runs the continuations of its future when it is completed or canceled, and passes its progress to them directly.
+ *    No QFutureWatcher is needed per observer. Only a future handed out is watched, for the cancellation made by QFuture::cancel().
+ */
+
+template <typename T>
+class DeferredFuture : public QObject, public QFutureInterface<T>, public ContinuationList {
+public:
+
+    ~DeferredFuture() {
+        cancel();
+
+        ContinuationRegistry* registry = ContinuationRegistry::of(&this->resultStoreBase());
+        registry->mutex.lock();
+        registry->deferreds.remove(&this->resultStoreBase());
+        registry->mutex.unlock();
+
+        delete watcher.loadAcquire();
+    }
+
+    /// Watch its own future for the cancellation made by QFuture::cancel(). The progress is passed to the continuations directly.
+    void prepare() {
+        if (watcher.loadAcquire() || isFinished()) {
+            return;
+        }
+
+        QFutureWatcher<T>* created = new QFutureWatcher<T>();
+        QObject::connect(created, &QFutureWatcher<T>::canceled, created, [=]() {
+            settle(true);
+        });
+
+        // Observers may prepare it at the same time
+        if (!watcher.testAndSetOrdered(nullptr, created)) {
+            delete created;
+            return;
+        }
+
+        if (thread() != QThread::currentThread()) {
+            created->moveToThread(thread());
+        }
+        Dispatcher::adopt(created);
+
+        created->setFuture(this->future());
+    }
+
+    /// Fails once the last reference is dropped
+    bool retain() {
+        int count = refCount.loadAcquire();
+
+        do {
+            if (count <= 0) {
+                return false;
+            }
+        } while (!refCount.testAndSetOrdered(count, count + 1, count));
+
+        return true;
+    }
+
+    void unretain() {
+        decWeakRefCount();
+    }
+
+    template <typename ANY>
+    void track(QFuture<ANY> future) {
+        QPointer<DeferredFuture<T>> thiz = this;
+        QFutureWatcher<ANY> *watcher = new QFutureWatcher<ANY>();
+
+        QThread* thread = Dispatcher::current()->thread();
+        if (thread != QThread::currentThread()) {
+            watcher->moveToThread(thread);
+        }
+
+        QObject::connect(watcher, &QFutureWatcher<ANY>::finished, [=]() {
+            watcher->disconnect();
+            watcher->deleteLater();
+        });
+
+        QObject::connect(watcher, &QFutureWatcher<ANY>::progressValueChanged, this, [=](int value) {
+            if (thiz.isNull()) {
+                return;
+            }
+            thiz->setWatchProgressValue(value);
+        });
+
+        QObject::connect(watcher, &QFutureWatcher<ANY>::progressRangeChanged, this, [=](int min, int max) {
+            if (thiz.isNull()) {
+                return;
+            }
+            thiz->setWatchProgressRange(min, max);
+        });
+
+        QObject::connect(watcher, &QFutureWatcher<ANY>::started, this, [=](){
+            thiz->reportStarted();
+        });
+
+        QObject::connect(watcher, &QFutureWatcher<ANY>::paused, this, [=](){
+            thiz->setPaused(true);
+        });
+
+        QObject::connect(watcher, &QFutureWatcher<ANY>::resumed, this, [=](){
+            thiz->setPaused(false);
+        });
+
+        watcher->setFuture(future);
+
+        setWatchProgressRange(future.progressMinimum(), future.progressMaximum());
+        setWatchProgressValue(future.progressValue());
+
+        if (future.isStarted()) {
+            QFutureInterface<T>::reportStarted();
+        }
+
+        if (future.isPaused()) {
+            QFutureInterface<T>::setPaused(true);
+        }
+    }
+
+    bool isFinished() const {
+        return QFutureInterface<T>::isFinished();
+    }
+
+    /// The future to be handed out. It could be canceled by QFuture::cancel().
+    QFuture<T> exposedFuture() {
+        prepare();
+        return this->future();
+    }
+
+    // complete<void>()
+    void complete() {
+        if (!claimFinish()) {
+            return;
+        }
+        finish();
+    }
+
+    template <typename R>
+    void complete(R value) {
+        if (!claimFinish()) {
+            return;
+        }
+        reportMovedResult(std::move(value));
+        finish();
+    }
+
+    template <typename R>
+    void complete(QList<R> value) {
+        if (!claimFinish()) {
+            return;
+        }
+
+        reportResult(std::move(value));
+        finish();
+    }
+
+    template <typename R>
+    void complete(Value<R> value) {
+        this->complete(std::move(value.value));
+    }
+
+    void complete(Value<void> value) {
+        Q_UNUSED(value);
+        this->complete();
+    }
 
     void complete(QFuture<T> future) {
         incWeakRefCount();
@@ -567,521 +1649,1347 @@ public:
             this->decWeakRefCount();
         };
 
-        auto onCanceled = [=]() {
-            this->cancel();
-            this->decWeakRefCount();
-        };
+        auto onCanceled = [=]() {
+            this->cancel();
+            this->decWeakRefCount();
+        };
+
+        watch(future,
+              this,
+              nullptr,
+              onFinished,
+              onCanceled,
+              [](int){},
+        [](int,int){}
+        );
+
+        auto pushCancel = [=]() {
+            cancelFuture(future);
+        };
+
+        //Pushes cancel to child futures in the chain
+        watch(this->future(),
+              this,
+              nullptr,
+              [](){},
+              pushCancel,
+              [](int){},
+        [](int,int){}
+        );
+
+        track(future);
+    }
+
+    template <typename ANY>
+    void complete(QFuture<QFuture<ANY>> future) {
+        incWeakRefCount();
+
+        auto onFinished = [=]() {
+            complete(future.result());
+            this->decWeakRefCount();
+        };
+
+        auto onCanceled = [=]() {
+            this->cancel();
+            this->decWeakRefCount();
+        };
+
+        watch(future,
+              this,
+              nullptr,
+              onFinished,
+              onCanceled,
+              [](int){},
+        [](int,int){});
+        // It don't track for the first level of future
+    }
+
+    void cancel() {
+        if (!claimFinish()) {
+            return;
+        }
+        QFutureInterface<T>::reportCanceled();
+        finish();
+    }
+
+    /// Cancel once the sender emits the signal. No reference is held, the connection is dropped once this object is destroyed.
+    template <typename Member>
+	void cancel(const QObject* sender, Member member) {
+        QObject::connect(sender, member,
+                         this, [=]() {
+            this->cancel();
+        });
+    }
+
+    template <typename ANY>
+    void cancel(QFuture<ANY> future) {
+        auto release = holdUntilFinished();
+        auto onFinished = [=]() {
+            cancel();
+            release();
+        };
+
+        auto onCanceled = [=]() {
+            release();
+        };
+
+        watch(future,
+              this,
+              nullptr,
+              onFinished,
+              onCanceled,
+              [](int){},
+              [](int,int){}
+        );
+    }
+
+    void incWeakRefCount(int count = 1) {
+        refCount.fetchAndAddOrdered(count);
+    }
+
+    /// Drop a reference. The last one cancels this future if it is not finished yet, then destroys this object.
+    void decWeakRefCount() {
+        int count = refCount.fetchAndAddOrdered(-1) - 1;
+
+        if (count > 0) {
+            return;
+        }
+
+        // No one could complete it anymore
+        if (!isFinished()) {
+            cancel();
+        }
+
+        //This prevents deletion this on a seperate thread
+        if(thread() != QThread::currentThread()) {
+            QMetaObject::invokeMethod(this, "deleteLater");
+        } else {
+            delete this;
+        }
+    }
+
+    /// Create a DeferredFugture instance and manage by a shared pointer
+    static DeferredPointer<DeferredFuture<T> > create() {
+        return DeferredPointer<DeferredFuture<T> >(new DeferredFuture<T>());
+    }
+
+    template <typename R>
+    void reportResult(R& value, int index = -1) {
+        QFutureInterface<T>::reportResult(value, index);
+    }
+
+    void reportResult(Value<void> &value) {
+        Q_UNUSED(value);
+    }
+
+    template <typename R>
+    void reportResult(QList<R>&& value) {
+        // The items could be moved only if the list is not shared with the caller
+        if (value.isDetached()) {
+            for (int i = 0 ; i < value.size();i++) {
+                reportMovedResult(std::move(value[i]), i);
+            }
+        } else {
+            for (int i = 0 ; i < value.size();i++) {
+                QFutureInterface<T>::reportResult(value.at(i), i);
+            }
+        }
+    }
+
+    /// Move the value into the result store. QFutureInterface<T>::reportResult() always makes a copy.
+    /** It is the same as QFutureInterface<T>::reportResult(const T*, int) except the stored item is move constructed.
+     */
+    template <typename R>
+    void reportMovedResult(R&& value, int index = -1) {
+        QMutexLocker locker(this->mutex());
+        if (this->queryState(QFutureInterfaceBase::Canceled) || this->queryState(QFutureInterfaceBase::Finished)) {
+            return;
+        }
+
+        QtPrivate::ResultStoreBase &store = this->resultStoreBase();
+
+        if (store.filterMode()) {
+            // A result out of order is held until the ones before it are reported. Then all of them are ready at once.
+            const int resultCountBefore = store.count();
+            store.addResult(index, static_cast<void*>(new T(std::forward<R>(value))));
+            this->reportResultsReady(resultCountBefore, store.count());
+        } else {
+            const int insertIndex = store.addResult(index, static_cast<void*>(new T(std::forward<R>(value))));
+            this->reportResultsReady(insertIndex, insertIndex + 1);
+        }
+    }
+
+    template <typename R>
+    void reportResult(Value<R>& value) {
+        QFutureInterface<T>::reportResult(value.value);
+    }
+
+    void setProgressCoalescing(ProgressCoalescing coalescing) {
+        progressGate.setCoalescing(coalescing);
+    }
+
+    /// Set the progress value reported by the user. It is coalesced according to setProgressCoalescing().
+    void setProgressValue(int value) {
+        publishProgressValue(value);
+    }
+
+    void setProgressRange(int minimum, int maximum) {
+        QFutureInterface<T>::setProgressRange(minimum, maximum);
+        notifyProgressRange(minimum, maximum);
+    }
+
+    void setParentProgressValue(int value) {
+        storeProgress(progressValues, Parent, value);
+        updateProgressValue();
+    }
+
+    void setParentProgressRange(int min, int max) {
+        storeProgress(progressRanges, Parent, max - min);
+        updateProgressRanges();
+    }
+
+protected:
+    DeferredFuture(QObject* parent = nullptr): QObject(parent),
+                                         QFutureInterface<T>(QFutureInterface<T>::Running),
+                                         refCount(0),
+                                         progressValues(0),
+                                         progressRanges(0),
+                                         finishing(0),
+                                         watcher(nullptr) {
+            moveToThread(Dispatcher::current()->thread());
+            Dispatcher::adopt(this);
+
+            ContinuationRegistry* registry = ContinuationRegistry::of(&this->resultStoreBase());
+            registry->mutex.lock();
+            registry->deferreds.insert(&this->resultStoreBase(), this);
+            registry->mutex.unlock();
+    }
+
+private:
+
+    /* A reference count system. It is held by DeferredPointer and the pending callbacks those could complete it.
+     * Once it is dropped to zero, this object is canceled and destroyed.
+     */
+    QAtomicInt refCount;
+
+    /* The progress of parent and watched future are packed into a 64 bits integer.
+     * The low 32 bits is the parent one. So that they are always read in pair.
+     */
+    enum ProgressSource {
+        Parent = 0,
+        Watch = 32
+    };
+
+    QAtomicInteger<quint64> progressValues;
+
+    // Packed (max - min) of the progress ranges
+    QAtomicInteger<quint64> progressRanges;
+
+    // Set by the first complete() or cancel(). So only one of them takes effect, even if they race in different threads.
+    QAtomicInt finishing;
+
+    // Created on demand by prepare()
+    QAtomicPointer<QFutureWatcher<T>> watcher;
+
+    bool claimFinish() {
+        return finishing.testAndSetOrdered(0, 1);
+    }
+
+    void finish() {
+        // The last value held back by the progress gate is passed on before finishing, as Qt ignores it after
+        int pending;
+        if (progressGate.takePending(&pending)) {
+            reportProgressValue(pending);
+        }
+        QFutureInterface<T>::reportFinished();
+        settle(QFutureInterface<T>::isCanceled());
+    }
+
+    /// Hold a reference until the returned function is called or this future is finished, whichever comes first.
+    /** Otherwise, a future that never finishes would keep a finished object alive.
+     */
+    std::function<void()> holdUntilFinished() {
+        QSharedPointer<QAtomicInt> released = QSharedPointer<QAtomicInt>::create();
+
+        auto release = [=]() {
+            if (released->testAndSetOrdered(0, 1)) {
+                this->decWeakRefCount();
+            }
+        };
+
+        incWeakRefCount();
+
+        watch(this->future(), this, this, release, release, [](int){}, [](int,int){});
+
+        return release;
+    }
+
+    void setWatchProgressValue(int value) {
+        storeProgress(progressValues, Watch, value);
+        updateProgressValue();
+    }
+
+    void setWatchProgressRange(int min, int max) {
+        storeProgress(progressRanges, Watch, max - min);
+        updateProgressRanges();
+    }
+
+    static void storeProgress(QAtomicInteger<quint64>& packed, ProgressSource source, int value) {
+        const quint64 mask = Q_UINT64_C(0xffffffff) << source;
+        quint64 current = packed.loadAcquire();
+        quint64 newValue;
+
+        do {
+            newValue = (current & ~mask) | (quint64(quint32(value)) << source);
+        } while (!packed.testAndSetOrdered(current, newValue, current));
+    }
+
+    // Summed in 64 bits, as each of them could be up to INT_MAX
+    static qint64 sumOf(quint64 packed) {
+        return qint64(int(quint32(packed))) + qint64(int(quint32(packed >> 32)));
+    }
+
+    /* The sum is published without a lock. A writer that raced with another one
+     * publishes again until the value it read is the latest one.
+     */
+    void updateProgressRanges() {
+        quint64 ranges = progressRanges.loadAcquire();
+        quint64 latest;
+
+        do {
+            int newMax = ProgressScale::maximum(sumOf(ranges));
+            if(QFutureInterface<T>::progressMaximum() != newMax) {
+                setProgressRange(0, newMax);
+            }
+            latest = ranges;
+            ranges = progressRanges.loadAcquire();
+        } while (ranges != latest);
+    }
+
+    void updateProgressValue() {
+        quint64 values = progressValues.loadAcquire();
+        quint64 latest;
+
+        do {
+            int newProgress = ProgressScale::value(sumOf(values), sumOf(progressRanges.loadAcquire()));
+            if(QFutureInterface<T>::progressValue() != newProgress) {
+                publishProgressValue(newProgress);
+            }
+            latest = values;
+            values = progressValues.loadAcquire();
+        } while (values != latest);
+    }
 
-        watch(future,
-              this,
-              nullptr,
-              onFinished,
-              onCanceled,
-              [](int){},
-        [](int,int){}
-        );
+    /// The future is already finished. It will take effect immediately
+    template <typename ANY>
+    typename std::enable_if<!std::is_same<ANY,void>::value, void>::type
+    completeByFinishedFuture(QFuture<T> future) {
+        if (!claimFinish()) {
+            return;
+        }
 
-        auto pushCancel = [=]() {
-            auto tmpFuture = future;
-            tmpFuture.cancel();
+        reportResultsOf(future);
+        finish();
+    }
+
+    template <typename ANY>
+    typename std::enable_if<std::is_same<ANY,void>::value, void>::type
+    completeByFinishedFuture(QFuture<T> future) {
+        Q_UNUSED(future);
+        complete();
+    }
+
+public:
+    /// Append the results of a finished future
+    /** The source result store is read under a single lock, and each result is copied once into a QVector.
+     *  The QVector is then handed over to the result store of this future as one batch, without another copy.
+     *  The results could not be moved out of the source, as its other observers still read them.
+     */
+    void reportResultsOf(QFuture<T> future) {
+        QVector<T>* batch = new QVector<T>();
+
+        {
+            QMutexLocker locker(future.d.mutex());
+            const QtPrivate::ResultStoreBase &source = future.d.resultStoreBase();
+            batch->reserve(source.count());
+            for (QtPrivate::ResultIteratorBase it = source.begin(); it != source.end(); ++it) {
+                batch->append(it.value<T>());
+            }
+        }
+
+        if (batch->isEmpty()) {
+            delete batch;
+            return;
+        }
+
+        QMutexLocker locker(this->mutex());
+        if (this->queryState(QFutureInterfaceBase::Canceled) || this->queryState(QFutureInterfaceBase::Finished)) {
+            delete batch;
+            return;
+        }
+
+        QtPrivate::ResultStoreBase &store = this->resultStoreBase();
+        const int count = batch->size();
+
+        // The store takes the ownership of the batch, as QFutureInterface<T>::reportResults() does with its copy
+        if (store.filterMode()) {
+            const int resultCountBefore = store.count();
+            store.addResults(-1, static_cast<const void*>(batch), count, count);
+            this->reportResultsReady(resultCountBefore, store.count());
+        } else {
+            const int insertIndex = store.addResults(-1, static_cast<const void*>(batch), count, count);
+            this->reportResultsReady(insertIndex, insertIndex + count);
+        }
+    }
+
+protected:
+    ProgressGate progressGate;
+
+    /// Report a progress value through the progress gate
+    void publishProgressValue(int value) {
+        auto flush = [this]() {
+            int pending;
+            if (progressGate.flushed(&pending)) {
+                reportProgressValue(pending);
+            }
         };
 
-        //Pushes cancel to child futures in the chain
-        watch(this->future(),
-              this,
-              nullptr,
-              [](){},
-              pushCancel,
-              [](int){},
-        [](int,int){}
+        if (progressGate.pass(value, QFutureInterface<T>::progressMaximum(), this, flush)) {
+            reportProgressValue(value);
+        }
+    }
+
+private:
+    void reportProgressValue(int value) {
+        QFutureInterface<T>::setProgressValue(value);
+        notifyProgressValue(QFutureInterface<T>::progressValue());
+    }
+};
+
+/// A QRunnable that runs a function. It is deleted by QThreadPool after run().
+template <typename F>
+class RunnableFunction : public QRunnable {
+public:
+    RunnableFunction(F func) : func(std::move(func)) {
+    }
+
+    void run() {
+        func();
+    }
+
+private:
+    F func;
+};
+
+class CombinedFuture: public DeferredFuture<void> {
+
+public:
+    enum Mode {
+        // Cancel once any future is canceled
+        FailFastMode,
+        // Wait for all futures to settle
+        AllSettledMode,
+        // Complete once any future is completed. The rest are canceled.
+        FirstCompletedMode,
+        // Complete once quorum futures are completed. Cancel once it is no longer possible.
+        // The rest are canceled as soon as the outcome is decided. A quorum less than 1 is taken as 1.
+        // It is decided to be impossible only once the futures are sealed, see scheduleSeal().
+        QuorumMode
+    };
+
+    CombinedFuture(Mode modeArg = FailFastMode, int quorumArg = 1) : DeferredFuture<void>(),
+        contextObject(nullptr),
+        parallelCancelThreshold(0),
+        settledCount(0),
+        completedCount(0),
+        count(0),
+        quorum(modeArg == FirstCompletedMode ? 1 : qMax(1, quorumArg)),
+        winner(-1),
+        totalValue(0),
+        totalMax(0),
+        anyCanceled(false),
+        sealed(false),
+        sealScheduled(false),
+        mode(modeArg)
+    {
+        //Cancel all sub futures if this future is cancelled
+        Private::watch(
+                    future(),
+                    this,
+                    this,
+                    [](){},
+        [this](){
+            cancelUnfinished();
+        },
+        [](int){},
+        [](int, int){}
         );
+    }
 
-        track(future);
+    /// Add a future.
+    /** @param weight The share of the future in the progress. The progress of the future is normalized to it,
+     *  whatever its own range is. If it is 0, the range of the future is used as it is.
+     */
+    template <typename T>
+    void addFuture(const QFuture<T> future, qint64 weight = 0) {
+        if (isFinished()) {
+            return;
+        }
+
+        incWeakRefCount();
+
+        mutex.lock();
+        int index = appendFuture(future, weight);
+        updateProgressRange();
+        mutex.unlock();
+
+        watchFutureAt(future, index);
+        scheduleSeal();
     }
 
-    template <typename ANY>
-    void complete(QFuture<QFuture<ANY>> future) {
+    /// Add a batch of futures. The storage is reserved once and all of them are registered under a single lock.
+    template <typename T>
+    void addFutures(const QList<QFuture<T>>& list) {
+        if (isFinished() || list.isEmpty()) {
+            return;
+        }
+
+        incWeakRefCount(list.size());
+
+        mutex.lock();
+        int first = count;
+        futures.reserve(count + list.size());
+        for (const QFuture<T>& future : list) {
+            appendFuture(future);
+        }
+        updateProgressRange();
+        mutex.unlock();
+
+        for (int i = 0 ; i < list.size(); i++) {
+            watchFutureAt(list[i], first + i);
+        }
+        scheduleSeal();
+    }
+
+    /// Add a batch of futures through a tree of sub-combiners.
+    /** The list is split into shards of at most shardSize futures. Each shard is counted by a sub-combiner of the
+     *  same mode, which watches its futures from a shard dispatcher thread. Then the sub-combiners are added
+     *  to this one. It is not applicable to FirstCompletedMode and QuorumMode, as they count the direct futures.
+     */
+    template <typename T>
+    void addFuturesSharded(const QList<QFuture<T>>& list, int shardSize) {
+        if (mode == FirstCompletedMode || mode == QuorumMode || shardSize <= 0 || list.size() <= shardSize) {
+            addFutures(list);
+            return;
+        }
+
+        // Hold the sub-combiners until they are added
+        QList<DeferredPointer<CombinedFuture>> shards;
+        QList<QFuture<void>> shardFutures;
+
+        for (int i = 0 ; i * shardSize < list.size() ; i++) {
+            auto shard = create(mode);
+            shard->contextObject = Dispatcher::shard(i);
+            shard->addFutures(list.mid(i * shardSize, shardSize));
+            shards << shard;
+            shardFutures << shard->future();
+        }
+
+        addFutures(shardFutures);
+    }
+
+    static DeferredPointer<CombinedFuture> create(Mode mode, int quorum = 1) {
+        return DeferredPointer<CombinedFuture>(new CombinedFuture(mode, quorum));
+    }
+
+    /// Add futures created by factories, keeping at most maxInFlight of them unsettled.
+    /** Each factory is a callable returning a QFuture. A slot is reserved for each of them, so this future
+     *  doesn't settle before all of them are called. The next factory is called as a future settles. The rest
+     *  of the factories are not called once this future is finished. maxInFlight <= 0 calls all of them at once.
+     */
+    template <typename Factory>
+    void addFactories(QList<Factory> factories, int maxInFlight) {
+        if (isFinished() || factories.isEmpty()) {
+            return;
+        }
+
+        QSharedPointer<FactoryContext<Factory>> context(new FactoryContext<Factory>());
+        context->factories = factories;
+        context->combined = DeferredPointer<CombinedFuture>(this);
+
+        mutex.lock();
+        context->first = count;
+        futures.reserve(count + factories.size());
+        for (int i = 0 ; i < factories.size(); i++) {
+            appendFuture(QFuture<void>());
+        }
+        updateProgressRange();
+        mutex.unlock();
+
+        int inFlight = maxInFlight > 0 ? qMin(maxInFlight, factories.size()) : factories.size();
+        context->next = inFlight;
+
+        for (int i = 0 ; i < inFlight ; i++) {
+            launchFactory(context, i);
+        }
+        scheduleSeal();
+    }
+
+    /// Cancel the futures in parallel on the global thread pool if more than threshold of them are unfinished. 0 disables it.
+    void setParallelCancelThreshold(int threshold) {
+        parallelCancelThreshold = threshold;
+    }
+
+    /// Set a callback to be invoked with the index of each future once it is completed, before this future settles.
+    /** It should be set before adding futures. The invocations are serialized in the thread of the callbacks of futures.
+     */
+    void onCompletedAt(std::function<void(int)> callback) {
+        completedAt = callback;
+    }
+
+    /// The index of the future that completed first in FirstCompletedMode. It is -1 if none did.
+    int winnerIndex() {
+        QMutexLocker locker(&mutex);
+        return winner;
+    }
+
+private:
+    class FutureInfo {
+    public:
+        FutureInfo() = default;
+        FutureInfo(QFuture<void> childFuture) :
+            childFuture(childFuture)
+        {}
+
+        qint64 max = 1;
+        qint64 value = 0;
+        qint64 weight = 0;
+        QFuture<void> childFuture;
+
+        // The share of the future in the totals
+        qint64 weightedMax() const {
+            return weight > 0 ? weight : max;
+        }
+
+        qint64 weightedValue() const {
+            return weight > 0 ? qint64(double(weight) * value / max) : value;
+        }
+    };
+
+    QMutex mutex;
+    // The receiver of the callbacks of the futures. The dispatcher of the calling thread is used if it is null.
+    const QObject* contextObject;
+    int parallelCancelThreshold;
+    int settledCount;
+    int completedCount;
+    int count;
+    int quorum;
+    int winner;
+    std::function<void(int)> completedAt;
+    bool anyCanceled;
+    // No more futures are expected in QuorumMode
+    bool sealed;
+    bool sealScheduled;
+    Mode mode;
+    // Stored inline. It is accessed by index under the mutex as appending may reallocate it.
+    QVector<FutureInfo> futures;
+
+    // Running totals of the weighted progress of child futures. They are updated by deltas,
+    // and scaled into the int range of QFutureInterface on publishing.
+    qint64 totalValue;
+    qint64 totalMax;
+
+    // Append a future to the storage. It must be called with the mutex locked.
+    int appendFuture(const QFuture<void>& future, qint64 weight = 0) {
+        int index = count++;
+
+        FutureInfo info(future);
+        info.weight = weight;
+        if(future.progressMaximum() > 0) {
+            info.max = future.progressMaximum();
+        }
+        info.value = future.progressValue();
+        totalMax += info.weightedMax();
+        totalValue += info.weightedValue();
+
+        futures.append(info);
+        Q_ASSERT(index == futures.size() - 1);
+        return index;
+    }
+
+    // The state of addFactories(). It is held by the callbacks of the futures in flight.
+    template <typename Factory>
+    class FactoryContext {
+    public:
+        QMutex mutex;
+        QList<Factory> factories;
+        int first = 0;
+        int next = 0;
+        DeferredPointer<CombinedFuture> combined;
+    };
+
+    template <typename Factory>
+    static void launchFactory(QSharedPointer<FactoryContext<Factory>> context, int index) {
+        CombinedFuture* combined = context->combined.data();
+        auto future = context->factories[index]();
+        combined->setFutureAt(context->first + index, future);
+
+        auto settled = [context]() {
+            context->mutex.lock();
+            int next = -1;
+            if (context->next < context->factories.size() && !context->combined->isFinished()) {
+                next = context->next++;
+            }
+            context->mutex.unlock();
+
+            if (next >= 0) {
+                launchFactory(context, next);
+            }
+        };
+
+        Private::watch(future, combined, combined->contextObject, settled, settled, [](int) {}, [](int, int) {});
+    }
+
+    // Fill a slot reserved by addFactories()
+    template <typename T>
+    void setFutureAt(int index, const QFuture<T>& future) {
         incWeakRefCount();
 
-        auto onFinished = [=]() {
-            complete(future.result());
-            this->decWeakRefCount();
+        mutex.lock();
+        futures[index].childFuture = future;
+        setMaxAt(index, future.progressMaximum());
+        setValueAt(index, future.progressValue());
+        updateProgressRange();
+        updateProgress();
+        mutex.unlock();
+
+        watchFutureAt(future, index);
+    }
+
+    template <typename T>
+    void watchFutureAt(const QFuture<T>& future, int index) {
+        auto progressFunc = [=](int progressValue) {
+            mutex.lock();
+            setValueAt(index, progressValue);
+            updateProgress();
+            mutex.unlock();
         };
 
-        auto onCanceled = [=]() {
-            this->cancel();
-            this->decWeakRefCount();
+        auto progressRangeFunc = [=](int min, int max) {
+            Q_UNUSED(min);
+            mutex.lock();
+            setMaxAt(index, max);
+            updateProgressRange();
+            updateProgress();
+            mutex.unlock();
         };
 
-        watch(future,
-              this,
-              nullptr,
-              onFinished,
-              onCanceled,
-              [](int){},
-        [](int,int){});
-        // It don't track for the first level of future
+        Private::watch(future, this, contextObject,
+                       [=]() {
+            completeFutureAt(index);
+            decWeakRefCount();
+        },[=]() {
+            cancelFutureAt(index);
+            decWeakRefCount();
+        },
+        progressFunc,
+        progressRangeFunc
+        );
+    }
+
+    void completeFutureAt(int index) {
+        mutex.lock();
+        settledCount++;
+        completedCount++;
+        if (mode == FirstCompletedMode && winner < 0) {
+            winner = index;
+        }
+        finishProgress(index);
+        mutex.unlock();
+
+        if (completedAt && !isFinished()) {
+            completedAt(index);
+        }
+
+        checkFulfilled();
+    }
+
+    void cancelFutureAt(int index) {
+        Q_UNUSED(index);
+
+        mutex.lock();
+        settledCount++;
+        anyCanceled = true;
+        finishProgress(index);
+        mutex.unlock();
+
+        checkFulfilled();
     }
 
-    void cancel() {
-        if (isFinished()) {
+    /* Seal the futures in QuorumMode once the callbacks of the calling thread are dispatched.
+     *
+     * So the futures added in the same event loop pass are all counted before the quorum is decided to be
+     * impossible. Otherwise it would be decided against a count that is still growing.
+     */
+    void scheduleSeal() {
+        if (mode != QuorumMode) {
             return;
         }
-        QFutureInterface<T>::reportCanceled();
-        QFutureInterface<T>::reportFinished();
-    }
 
-    template <typename Member>
-	void cancel(const QObject* sender, Member member) {
-        incWeakRefCount();
-        QObject::connect(sender, member,
-                         this, [=]() {
-            this->cancel();
-            decWeakRefCount();
-        });
-    }
+        mutex.lock();
+        bool post = !sealScheduled;
+        sealScheduled = true;
+        mutex.unlock();
+
+        if (!post) {
+            return;
+        }
 
-    template <typename ANY>
-    void cancel(QFuture<ANY> future) {
         incWeakRefCount();
-        auto onFinished = [=]() {
-            cancel();
-            decWeakRefCount();
-        };
+        runInThread(contextObject ? contextObject : Dispatcher::current(), [this]() {
+            mutex.lock();
+            sealed = true;
+            mutex.unlock();
 
-        auto onCanceled = [=]() {
+            checkFulfilled();
             decWeakRefCount();
-        };
-
-        watch(future,
-              this,
-              nullptr,
-              onFinished,
-              onCanceled,
-              [](int){},
-              [](int,int){}
-        );
-    }
-
-    void incWeakRefCount() {
-        mutex.lock();
-        refCount++;
-        mutex.unlock();
+        });
     }
 
-    void decWeakRefCount() {
-        int count;
+    void checkFulfilled() {
+        if (isFinished()) {
+            return;
+        }
 
-        mutex.lock();
-        refCount--;
-        count = refCount;
-        mutex.unlock();
+        if (mode == FirstCompletedMode || mode == QuorumMode) {
+            mutex.lock();
+            int failedCount = settledCount - completedCount;
+            bool reached = completedCount >= quorum;
+            bool impossible = (mode != QuorumMode || sealed) && count - failedCount < quorum;
+            mutex.unlock();
 
-        if (count <= 0) {
-            if (!isFinished()) {
+            if (reached) {
+                cancelUnfinished();
+                complete();
+            } else if (impossible) {
+                cancelUnfinished();
                 cancel();
             }
+            return;
+        }
+
+        if (anyCanceled && mode == FailFastMode) {
+            cancel();
+            return;
         }
 
-        if (strongRefCount == 0 && isFinished()) {
-            //This prevents deletion this on a seperate thread
-            if(thread() != QThread::currentThread()) {
-                QMetaObject::invokeMethod(this, "deleteLater");
+        if (settledCount == count) {
+            if (anyCanceled) {
+                cancel();
             } else {
-                delete this;
+                complete();
             }
         }
     }
 
-    void incStrongRef() {
+    // Cancel the futures those are still running. They are collected under the lock but canceled outside it,
+    // as each cancel() takes the lock of the future and may deliver its signals synchronously.
+    void cancelUnfinished() {
+        QVector<QFuture<void>> pending;
         mutex.lock();
-        strongRefCount++;
+        pending.reserve(futures.size());
+        for (const FutureInfo& info : futures) {
+            if (info.childFuture.isRunning() && !info.childFuture.isFinished()) {
+                pending << info.childFuture;
+            }
+        }
+        int threshold = parallelCancelThreshold;
         mutex.unlock();
-    }
 
-    void decStrongRef() {
-        mutex.lock();
-        strongRefCount--;
-        mutex.unlock();
-    }
+        if (threshold <= 0 || pending.size() <= threshold) {
+            cancelFutures(pending, 0, pending.size());
+            return;
+        }
 
-    /// Create a DeferredFugture instance and manage by a shared pointer
-    static QSharedPointer<DeferredFuture<T> > create() {
+        // Split into a chunk per thread. The first chunk is canceled by the calling thread.
+        int chunks = qMax(2, QThread::idealThreadCount());
+        int chunkSize = (pending.size() + chunks - 1) / chunks;
 
-        auto deleter = [](DeferredFuture<T> *object) {
-            object->decStrongRef();
-            object->decWeakRefCount();
-        };
+        for (int begin = chunkSize ; begin < pending.size() ; begin += chunkSize) {
+            int end = qMin(begin + chunkSize, pending.size());
+            auto func = [pending, begin, end]() {
+                cancelFutures(pending, begin, end);
+            };
+            QThreadPool::globalInstance()->start(new RunnableFunction<decltype(func)>(func));
+        }
 
-        QSharedPointer<DeferredFuture<T> > ptr(new DeferredFuture<T>(), deleter);
-        ptr->incStrongRef();
-        return ptr;
+        cancelFutures(pending, 0, chunkSize);
     }
 
-    template <typename R>
-    void reportResult(R& value, int index = -1) {
-        QFutureInterface<T>::reportResult(value, index);
+    static void cancelFutures(const QVector<QFuture<void>>& futures, int begin, int end) {
+        for (int i = begin ; i < end ; i++) {
+            cancelFuture(futures[i]);
+        }
     }
 
-    void reportResult(Value<void> &value) {
-        Q_UNUSED(value);
+    void setValueAt(int index, qint64 value) {
+        FutureInfo& info = futures[index];
+        totalValue -= info.weightedValue();
+        info.value = value;
+        totalValue += info.weightedValue();
     }
 
-    template <typename R>
-    void reportResult(QList<R>& value) {
-        for (int i = 0 ; i < value.size();i++) {
-            QFutureInterface<T>::reportResult(value[i], i);
+    void setMaxAt(int index, qint64 max) {
+        if (max <= 0) {
+            return;
         }
+        FutureInfo& info = futures[index];
+        totalMax -= info.weightedMax();
+        totalValue -= info.weightedValue();
+        info.max = max;
+        totalMax += info.weightedMax();
+        totalValue += info.weightedValue();
     }
 
-    template <typename R>
-    void reportResult(Value<R>& value) {
-        QFutureInterface<T>::reportResult(value.value);
+    void updateProgressRange() {
+        int max = ProgressScale::maximum(totalMax);
+        if (QFutureInterface<void>::progressMaximum() != max) {
+            setProgressRange(0, max);
+        }
     }
 
-    void setParentProgressValue(int value) {
-        mutex.lock();
-        parentProgress.value = value;
-        updateProgressValue();
-        mutex.unlock();
+    void updateProgress() {
+        publishProgressValue(ProgressScale::value(totalValue, totalMax));
     }
 
-    void setParentProgressRange(int min, int max) {
-        mutex.lock();
-        parentProgress.min = min;
-        parentProgress.max = max;
-        updateProgressRanges();
-        mutex.unlock();
+    void finishProgress(int index) {
+        setValueAt(index, futures[index].max);
+        updateProgress();
     }
 
-protected:
-    DeferredFuture(QObject* parent = nullptr): QObject(parent),
-                                         QFutureInterface<T>(QFutureInterface<T>::Running),
-                                         refCount(1),
-                                         strongRefCount(0) {
-            moveToThread(QCoreApplication::instance()->thread());
+};
+
+/// Proxy is a proxy class to connect a QObject signal to a callback function
+template <typename ARG, typename Arguments = signal_arguments<ARG>>
+class Proxy : public QObject {
+public:
+    Proxy(QObject* parent) : QObject(parent) {
     }
 
-    QMutex mutex;
+    QVector<int> parameterTypes;
+    std::function<void(Value<ARG>)> callback;
+    QMetaObject::Connection conn;
+    QPointer<QObject> sender;
+    // Disconnect after the first emission
+    bool once = true;
 
-private:
+    /// @param type The connection type. A direct connection invokes the callback inside the emission.
+    template <typename Method>
+    void bind(QObject* source, Method pointToMemberFunction, Qt::ConnectionType type = Qt::QueuedConnection) {
+        sender = source;
 
-    // A reference count system. If it is dropped to zero, it will cancel this object
-    int refCount;
+        const int memberOffset = QObject::staticMetaObject.methodCount();
 
-    // Unless it is zero, this object will not be destroyed.
-    int strongRefCount;
+        QMetaMethod method = QMetaMethod::fromSignal(pointToMemberFunction);
 
-    class Progress {
-    public:
-        int range() { return max - min; }
+        parameterTypes = QVector<int>(method.parameterCount());
 
-        int value = 0;
-        int min = 0;
-        int max = 0;
-    };
+        for (int i = 0 ; i < method.parameterCount() ; i++) {
+            parameterTypes[i] = method.parameterType(i);
+        }
 
-    Progress parentProgress;
-    Progress watchProgress;
+        conn = QMetaObject::connect(source, method.methodIndex(), this, memberOffset, type, 0);
 
-    void setWatchProgressValue(int value) {
-        mutex.lock();
-        watchProgress.value = value;
-        updateProgressValue();
-        mutex.unlock();
+        if (!conn) {
+            qWarning() << "AsyncFuture::Private::Proxy: Failed to bind signal";
+        }
     }
 
-    void setWatchProgressRange(int min, int max) {
-        mutex.lock();
-        watchProgress.min = min;
-        watchProgress.max = max;
-        updateProgressRanges();
-        mutex.unlock();
-    }
+    int qt_metacall(QMetaObject::Call _c, int _id, void **_a) {
+        int methodId = QObject::qt_metacall(_c, _id, _a);
 
-    void updateProgressRanges() {
-        int newMax = parentProgress.range() + watchProgress.range();
-        if(QFutureInterface<T>::progressMaximum() != newMax) {
-            QFutureInterface<T>::setProgressRange(0, newMax);
+        if (methodId < 0) {
+            return methodId;
         }
-    }
 
-    void updateProgressValue() {
-        int newProgress = parentProgress.value + watchProgress.value;
-        if(QFutureInterface<T>::progressValue() != newProgress) {
-            QFutureInterface<T>::setProgressValue(newProgress);
+        if (_c == QMetaObject::InvokeMetaMethod) {
+            if (methodId == 0) {
+                if (once) {
+                    sender->disconnect(conn);
+                }
+                callback(Arguments::value(_a));
+            }
         }
+        return methodId;
     }
+};
 
-    /// The future is already finished. It will take effect immediately
-    template <typename ANY>
-    typename std::enable_if<!std::is_same<ANY,void>::value, void>::type
-    completeByFinishedFuture(QFuture<T> future) {
-        if (future.resultCount() > 1) {
-            complete(future.results());
-        } else if (future.resultCount() == 1) {
-            complete(future.result());
-        } else {
-            complete();
+/// StreamProxy reports every emission of a signal as a result of a stream.
+/** The emissions are buffered and reported in a batch on the next event loop pass of the thread of the proxy.
+ *  At most batchSize of them are buffered per pass, unless it is 0.
+ */
+template <typename T, typename Arguments = signal_arguments<T>>
+class StreamProxy : public Proxy<T, Arguments> {
+public:
+    StreamProxy(DeferredPointer<DeferredFuture<T>> defer, int batchSize, StreamOverflow overflow) :
+        Proxy<T, Arguments>(nullptr),
+        defer(defer),
+        batchSize(batchSize),
+        overflow(overflow),
+        scheduled(false) {
+        this->once = false;
+        this->callback = [this](Value<T> value) {
+            append(std::move(value.value));
+        };
+    }
+
+    void flush() {
+        scheduled = false;
+        if (buffer.isEmpty()) {
+            return;
         }
+        defer->reportResults(buffer);
+        buffer.clear();
     }
 
-    template <typename ANY>
-    typename std::enable_if<std::is_same<ANY,void>::value, void>::type
-    completeByFinishedFuture(QFuture<T> future) {
-        Q_UNUSED(future);
-        complete();
+    /// Report the buffered emissions and complete the stream. The proxy is deleted.
+    void finish() {
+        flush();
+        defer->complete();
+        delete this;
     }
 
-protected:
-};
+    /// Disconnect the signal as soon as the stream is canceled, from whatever thread cancels it.
+    /** Otherwise the emissions queued until the proxy is deleted by its own thread would still be buffered.
+     */
+    void disconnectOnCancel() {
+        defer->append(new Disconnection(this->conn));
+    }
 
-class CombinedFuture: public DeferredFuture<void> {
+private:
+    class Disconnection : public Continuation {
+    public:
+        Disconnection(QMetaObject::Connection conn) : conn(conn) {
+        }
 
-public:
-    CombinedFuture(bool settleAllModeArg = false) : DeferredFuture<void>(),
-        settledCount(0),
-        count(0),
-        anyCanceled(false),
-        settleAllMode(settleAllModeArg)
-    {
-        //Cancel all sub futures if this future is cancelled
-        Private::watch(
-                    future(),
-                    this,
-                    this,
-                    [](){},
-        [this](){
-            mutex.lock();
-            for(FutureInfo* info : futures) {
-                if(info->childFuture.isRunning() && !info->childFuture.isFinished()) {
-                    info->childFuture.cancel();
-                }
+        void settle(bool canceled) {
+            if (canceled) {
+                QObject::disconnect(conn);
             }
-            mutex.unlock();
-        },
-        [](int){},
-        [](int, int){}
-        );
-    }
-
-    ~CombinedFuture() {
-        for(auto progress : futures) {
-            delete progress;
         }
-    }
 
-    template <typename T>
-    void addFuture(const QFuture<T> future) {
-        if (isFinished()) {
-            return;
+        void progressValueChanged(int) {
         }
 
-        incWeakRefCount();
+        void progressRangeChanged(int, int) {
+        }
 
-        mutex.lock();
-        int index = count++;
+    private:
+        QMetaObject::Connection conn;
+    };
 
+    DeferredPointer<DeferredFuture<T>> defer;
+    int batchSize;
+    StreamOverflow overflow;
+    QVector<T> buffer;
+    bool scheduled;
 
-        auto info = new FutureInfo(future);
-        futures.append(info);
-        Q_ASSERT(index == futures.size() - 1);
+    void append(T value) {
+        // An emission queued before the stream was canceled
+        if (defer->isCanceled()) {
+            buffer.clear();
+            return;
+        }
 
-        if(future.progressMaximum() > 0) {
-            info->max = future.progressMaximum();
+        if (batchSize > 0 && buffer.size() >= batchSize) {
+            switch (overflow) {
+            case DropOldest:
+                buffer.removeFirst();
+                break;
+            case DropNewest:
+                return;
+            default:
+                flush();
+                break;
+            }
         }
-        info->value = future.progressValue();
 
-        auto progressFunc = [=](int progressValue) {
-            mutex.lock();
-            info->value = progressValue;
-            updateProgress();
-            mutex.unlock();
-        };
+        buffer.append(std::move(value));
 
-        auto progressRangeFunc = [=](int min, int max) {
-            Q_UNUSED(min);
-            mutex.lock();
-            if(max > 0) {
-                info->max = max;
-            }
-            updateProgressRange();
-            mutex.unlock();
-        };
+        if (!scheduled) {
+            scheduled = true;
+            // It is dropped if the proxy is deleted
+            runInThread(this, [this]() {
+                flush();
+            });
+        }
+    }
+};
 
-        QFutureInterface<void>::setProgressRange(0, progressMaximum() + info->max);
-        mutex.unlock();
+/// The key of a shared proxy. Observers of a signal share a proxy if they are in the same thread and use the same connection type.
+class SharedProxyKey {
+public:
+    const QObject* sender;
+    int signal;
+    QThread* thread;
+    int type;
 
-        Private::watch(future, this, 0,
-                       [=]() {
-            completeFutureAt(index);
-            decWeakRefCount();
-        },[=]() {
-            cancelFutureAt(index);
-            decWeakRefCount();
-        },
-        progressFunc,
-        progressRangeFunc
-        );
+    bool operator==(const SharedProxyKey& other) const {
+        return sender == other.sender && signal == other.signal && thread == other.thread && type == other.type;
     }
+};
 
-    static QSharedPointer<CombinedFuture> create(bool settleAllMode) {
+inline uint qHash(const SharedProxyKey& key, uint seed = 0) {
+    return ::qHash(key.sender, seed) ^ ::qHash(key.thread, seed) ^ uint(key.signal) ^ (uint(key.type) << 16);
+}
 
-        auto deleter = [](CombinedFuture *object) {
-            // Regardless of the no. of instance of QSharedPointer<CombinedFuture>,
-            // it only increase the reference by one.
-            object->decStrongRef();
-            object->decWeakRefCount();
-        };
+/// SharedProxy completes all the pending observers of a signal from one connection.
+/** It is shared by (sender, signal, thread, connection type). It is removed once the signal is emitted,
+ *  the sender is destroyed, or all of its observers are canceled. The next observer creates a new one.
+ *
+ *  An observer is tracked by a raw pointer and a reference count, as the pending signal could still complete it.
+ *  It is removed as soon as it is canceled, and the connection is dropped with the last one.
+ */
+template <typename T, typename Arguments = signal_arguments<T>>
+class SharedProxy : public Proxy<T, Arguments> {
+public:
+    template <typename Method>
+    static void observe(QObject* source, Method pointToMemberFunction, Qt::ConnectionType type,
+                        DeferredFuture<T>* defer) {
+        SharedProxyKey key;
+        key.sender = source;
+        key.signal = QMetaMethod::fromSignal(pointToMemberFunction).methodIndex();
+        key.thread = QThread::currentThread();
+        key.type = type;
+
+        mutex().lock();
+        SharedProxy* proxy = registry().value(key, nullptr);
+
+        if (!proxy) {
+            proxy = new SharedProxy(key);
+            registry().insert(key, proxy);
+
+            QObject::connect(source, &QObject::destroyed, proxy, [proxy]() {
+                proxy->settle(nullptr);
+            });
+
+            // The settle above is queued if the sender lives in another thread. Until it runs, a new object
+            // at the same address must not join this proxy, so the entry is removed inside the destruction.
+            // Without a context object, the functor is invoked directly by the destroyed signal.
+            proxy->destroyedConn = QObject::connect(source, &QObject::destroyed, [key]() {
+                QMutexLocker locker(&mutex());
+                registry().remove(key);
+            });
+
+            proxy->callback = [proxy](Value<T> value) {
+                proxy->settle(&value);
+            };
+            proxy->bind(source, pointToMemberFunction, type);
+        }
+
+        defer->incWeakRefCount();
+        proxy->observers << defer;
+        mutex().unlock();
 
-        QSharedPointer<CombinedFuture> ptr(new CombinedFuture(settleAllMode), deleter);
-        ptr->incStrongRef();
-        return ptr;
+        // It is settled immediately if the observer is canceled already, so it is appended without the lock
+        defer->append(new Removal(key, defer));
     }
 
 private:
-    class FutureInfo {
+    /// Remove the observer from the proxy once it is canceled
+    class Removal : public Continuation {
     public:
-        FutureInfo() = default;
-        FutureInfo(QFuture<void> childFuture) :
-            childFuture(childFuture)
-        {}
+        Removal(SharedProxyKey key, DeferredFuture<T>* observer) : key(key), observer(observer) {
+        }
+
+        void settle(bool canceled) {
+            if (canceled) {
+                SharedProxy::remove(key, observer);
+            }
+        }
+
+        void progressValueChanged(int) {
+        }
 
-        int max = 1;
-        int value = 0;
-        QFuture<void> childFuture;
+        void progressRangeChanged(int, int) {
+        }
+
+    private:
+        SharedProxyKey key;
+        DeferredFuture<T>* observer;
     };
 
-    int settledCount;
-    int count;
-    bool anyCanceled;
-    bool settleAllMode;
-    QVector<FutureInfo*> futures;
+    SharedProxyKey key;
+    QList<DeferredFuture<T>*> observers;
+    // Set once it is settled or abandoned. Only the caller that sets it deletes the proxy.
+    bool done;
+    // Removes the entry once the sender is destroyed
+    QMetaObject::Connection destroyedConn;
 
-    void completeFutureAt(int index) {
-        Q_UNUSED(index);
-        mutex.lock();
-        settledCount++;
-        finishProgress(index);
-        mutex.unlock();
-        checkFulfilled();
+    SharedProxy(SharedProxyKey key) : Proxy<T, Arguments>(nullptr), key(key), done(false) {
+        this->once = false;
     }
 
-    void cancelFutureAt(int index) {
-        Q_UNUSED(index);
-
-        mutex.lock();
-        settledCount++;
-        anyCanceled = true;
-        finishProgress(index);
-        mutex.unlock();
+    static QMutex& mutex() {
+        static QMutex* mutex = new QMutex();
+        return *mutex;
+    }
 
-        checkFulfilled();
+    static QHash<SharedProxyKey, SharedProxy*>& registry() {
+        static QHash<SharedProxyKey, SharedProxy*>* registry = new QHash<SharedProxyKey, SharedProxy*>();
+        return *registry;
     }
 
-    void checkFulfilled() {
-        if (isFinished()) {
-            return;
+    // Take the observers and remove this proxy from the registry. It must be called with the mutex locked.
+    QList<DeferredFuture<T>*> detach() {
+        if (registry().value(key, nullptr) == this) {
+            registry().remove(key);
         }
+        QList<DeferredFuture<T>*> result = observers;
+        observers.clear();
+        return result;
+    }
 
-        if (anyCanceled && !settleAllMode) {
-            cancel();
+    /// Complete the observers with the value, or cancel them if it is null. The proxy is deleted later,
+    /// as it may be called by its own callback.
+    void settle(Value<T>* value) {
+        mutex().lock();
+        if (done) {
+            mutex().unlock();
             return;
         }
+        done = true;
+        QList<DeferredFuture<T>*> list = detach();
+        mutex().unlock();
 
-        if (settledCount == count) {
-            if (anyCanceled) {
-                cancel();
+        disconnectSender();
+
+        for (int i = 0 ; i < list.size() ; i++) {
+            if (value) {
+                Value<T> copy = *value;
+                list[i]->complete(std::move(copy));
             } else {
-                complete();
+                list[i]->cancel();
             }
+            list[i]->decWeakRefCount();
         }
+
+        this->deleteLater();
     }
 
-    void updateProgressRange() {
-        int max = std::accumulate(futures.begin(),
-                                  futures.end(),
-                                  0,
-                                  [](int current, const FutureInfo* info)
-        {
-            return info->max + current;
-        });
+    /// Remove a canceled observer. The connection is dropped once no observer is left.
+    static void remove(const SharedProxyKey& key, DeferredFuture<T>* observer) {
+        mutex().lock();
+        SharedProxy* proxy = registry().value(key, nullptr);
 
-        QFutureInterface<void>::setProgressRange(0, max);
-    }
+        if (!proxy || !proxy->observers.removeOne(observer)) {
+            // Settled already
+            mutex().unlock();
+            return;
+        }
 
-    void updateProgress() {
-        int value = std::accumulate(futures.begin(),
-                                  futures.end(),
-                                  0,
-                                  [](int current, const FutureInfo* info)
-        {
-            return info->value + current;
+        bool empty = proxy->observers.isEmpty();
+        if (empty) {
+            proxy->done = true;
+            proxy->detach();
+        }
+        mutex().unlock();
+
+        // It is called while the observer is settled, so its reference is dropped afterward
+        runInThread(observer, [observer]() {
+            observer->decWeakRefCount();
         });
 
-        QFutureInterface<void>::setProgressValue(value);
+        if (empty) {
+            proxy->disconnectSender();
+            proxy->deleteLater();
+        }
     }
 
-    void finishProgress(int index) {
-        futures[index]->value = futures[index]->max;
-        updateProgress();
+    void disconnectSender() {
+        if (!this->sender.isNull()) {
+            this->sender->disconnect(this->conn);
+        }
+        QObject::disconnect(destroyedConn);
     }
-
 };
 
-/// Proxy is a proxy class to connect a QObject signal to a callback function
-template <typename ARG>
-class Proxy : public QObject {
+/// SignalCache resolves a signal signature of a meta object to its method index and parameter types.
+/** The result is cached by (meta object, signature), so a signature is parsed and looked up only once.
+ */
+class SignalCache {
 public:
-    Proxy(QObject* parent) : QObject(parent) {
-    }
+    class Signal {
+    public:
+        int index = -1;
+        QVector<int> parameterTypes;
+    };
 
-    QVector<int> parameterTypes;
-    std::function<void(Value<ARG>)> callback;
-    QMetaObject::Connection conn;
-    QPointer<QObject> sender;
+    /// Return the signal. Its index is -1 if there is no such signal.
+    static Signal resolve(const QMetaObject* metaObject, const QString& signature) {
+        SignalCache* cache = instance();
+        Key key(metaObject, signature);
+
+        cache->mutex.lock();
+        auto iter = cache->entries.constFind(key);
+        if (iter != cache->entries.constEnd()) {
+            Signal signal = iter.value();
+            cache->mutex.unlock();
+            return signal;
+        }
+        cache->mutex.unlock();
 
-    template <typename Method>
-    void bind(QObject* source, Method pointToMemberFunction) {
-        sender = source;
+        Signal signal = lookup(metaObject, signature);
 
-        const int memberOffset = QObject::staticMetaObject.methodCount();
+        if (signal.index >= 0) {
+            cache->mutex.lock();
+            cache->entries.insert(key, signal);
+            cache->mutex.unlock();
+        }
 
-        QMetaMethod method = QMetaMethod::fromSignal(pointToMemberFunction);
+        return signal;
+    }
 
-        parameterTypes = QVector<int>(method.parameterCount());
+private:
+    typedef QPair<const QMetaObject*, QString> Key;
 
-        for (int i = 0 ; i < method.parameterCount() ; i++) {
-            parameterTypes[i] = method.parameterType(i);
-        }
+    QMutex mutex;
+    QHash<Key, Signal> entries;
 
-        conn = QMetaObject::connect(source, method.methodIndex(), this, memberOffset, Qt::QueuedConnection, 0);
+    static SignalCache* instance() {
+        // It is never destroyed, as a signal may be observed at exit
+        static SignalCache* cache = new SignalCache();
+        return cache;
+    }
 
-        if (!conn) {
-            qWarning() << "AsyncFuture::Private::Proxy: Failed to bind signal";
+    static Signal lookup(const QMetaObject* metaObject, const QString& signature) {
+        // Remove the leading code number added by SIGNAL()
+        int start = 0;
+        while (start < signature.size() && signature.at(start).isDigit()) {
+            start++;
         }
-    }
 
-    int qt_metacall(QMetaObject::Call _c, int _id, void **_a) {
-        int methodId = QObject::qt_metacall(_c, _id, _a);
+        QByteArray name = signature.mid(start).toUtf8();
 
-        if (methodId < 0) {
-            return methodId;
+        Signal signal;
+        signal.index = metaObject->indexOfSignal(name.constData());
+
+        if (signal.index < 0) {
+            signal.index = metaObject->indexOfSignal(QMetaObject::normalizedSignature(name.constData()).constData());
         }
 
-        if (_c == QMetaObject::InvokeMetaMethod) {
-            if (methodId == 0) {
-                sender->disconnect(conn);
-                if (parameterTypes.count() > 0) {
-                    Value<ARG> value(reinterpret_cast<ARG*>(_a[1]));
-                    callback(value);
-                } else {
-                    // It is triggered only if ARG==void.
-                    callback(Value<ARG>((ARG*) 0));
-                }
-            }
+        if (signal.index < 0) {
+            return signal;
         }
-        return methodId;
+
+        QMetaMethod method = metaObject->method(signal.index);
+        signal.parameterTypes = QVector<int>(method.parameterCount());
+
+        for (int i = 0 ; i < method.parameterCount() ; i++) {
+            signal.parameterTypes[i] = method.parameterType(i);
+        }
+
+        return signal;
     }
 };
 
@@ -1096,30 +3004,21 @@ public:
     QMetaObject::Connection conn;
     QPointer<QObject> sender;
 
-    inline bool bind(QObject* source,QString signal) {
+    inline bool bind(QObject* source,QString signal, Qt::ConnectionType type = Qt::QueuedConnection) {
         sender = source;
 
-        // Remove leading number
-        signal = signal.replace(QRegExp("^[0-9]*"), "");
-
         const int memberOffset = QObject::staticMetaObject.methodCount();
 
-        int index = source->metaObject()->indexOfSignal(signal.toUtf8().constData());
+        SignalCache::Signal resolved = SignalCache::resolve(source->metaObject(), signal);
 
-        if (index < 0) {
+        if (resolved.index < 0) {
             qWarning() << "AsyncFuture::Private::Proxy: No such signal: " << signal;
             return false;
         }
 
-        QMetaMethod method = source->metaObject()->method(index);
+        parameterTypes = resolved.parameterTypes;
 
-        parameterTypes = QVector<int>(method.parameterCount());
-
-        for (int i = 0 ; i < method.parameterCount() ; i++) {
-            parameterTypes[i] = method.parameterType(i);
-        }
-
-        conn = QMetaObject::connect(source, method.methodIndex(), this, memberOffset, Qt::QueuedConnection, 0);
+        conn = QMetaObject::connect(source, resolved.index, this, memberOffset, type, 0);
 
         if (!conn) {
             qWarning() << "AsyncFuture::Private::Proxy: Failed to bind signal";
@@ -1182,65 +3081,362 @@ call(Functor& functor, QFuture<T>& future) {
     return functor(future);
 }
 
-template <typename Functor, typename T>
-typename std::enable_if<!is_callable<Functor, T>::value, RetType<Functor>>::type
-call(Functor& functor, QFuture<T>& future) {
-    Q_UNUSED(functor);
-    Q_UNUSED(future);
-    static_assert(False<T>::value, ASYNCFUTURE_ERROR_ARGUMENT_MISMATCHED);
-}
+template <typename Functor, typename T>
+typename std::enable_if<!is_callable<Functor, T>::value, RetType<Functor>>::type
+call(Functor& functor, QFuture<T>& future) {
+    Q_UNUSED(functor);
+    Q_UNUSED(future);
+    static_assert(False<T>::value, ASYNCFUTURE_ERROR_ARGUMENT_MISMATCHED);
+}
+
+/* eval() : Evaluate the expression - "return functor(future)" that may have a void return type */
+
+template <typename Functor, typename T>
+typename std::enable_if<ret_type_is_void<Functor>::value && arg_count_is_zero<Functor>::value,
+Value<RetType<Functor>>>::type
+eval(Functor functor, QFuture<T> future) {
+    Q_UNUSED(future);
+    functor();
+    return Value<void>();
+}
+
+template <typename Functor, typename T>
+typename std::enable_if<ret_type_is_void<Functor>::value && !arg_count_is_zero<Functor>::value,
+Value<RetType<Functor>>>::type
+eval(Functor functor, QFuture<T> future) {
+    // callIgnoreReturn() is designed to reduce the no. of annoying compiler error messages.
+    callIgnoreReturn(functor, future);
+    return Value<void>();
+}
+
+template <typename Functor, typename T>
+typename std::enable_if<!ret_type_is_void<Functor>::value && arg_count_is_zero<Functor>::value,
+Value<RetType<Functor>>>::type
+eval(Functor functor, QFuture<T> future) {
+    Q_UNUSED(future);
+    return functor();
+}
+
+template <typename Functor, typename T>
+typename std::enable_if<!ret_type_is_void<Functor>::value && !arg_count_is_zero<Functor>::value,
+Value<RetType<Functor>>>::type
+eval(Functor functor, QFuture<T> future) {
+    return call(functor, future);
+}
+
+/// Report the results of finished futures in order
+template <typename T>
+void reportResultsOf(DeferredFuture<T>* defer, const QList<QFuture<T>>& futures) {
+    for (int i = 0 ; i < futures.size() ; i++) {
+        defer->reportResultsOf(futures[i]);
+    }
+}
+
+inline void reportResultsOf(DeferredFuture<void>* defer, const QList<QFuture<void>>& futures) {
+    Q_UNUSED(defer);
+    Q_UNUSED(futures);
+}
+
+template <typename... Args>
+struct any_void : std::false_type {
+};
+
+template <typename Head, typename... Tail>
+struct any_void<Head, Tail...> : std::integral_constant<bool, std::is_same<Head, void>::value || any_void<Tail...>::value> {
+};
+
+/// True if every future has a result
+template <typename... Args>
+bool haveResults(const QFuture<Args>&... futures) {
+    bool results[] = { (futures.resultCount() > 0)... };
+
+    for (bool result : results) {
+        if (!result) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // End of Private Namespace
+
+/* Executor decides where the callback of then() runs.
+ *
+ * It is a copyable handle. Built-in executors are created by the static functions,
+ * and a user-defined queue is supported by the constructor taking a dispatcher function.
+ */
+class Executor {
+public:
+    typedef std::function<void()> Task;
+
+    /// Pass the tasks to a user-defined queue. The dispatcher could be called from any thread.
+    explicit Executor(std::function<void(Task)> dispatcher) : m_kind(Custom), m_dispatcher(dispatcher) {
+    }
+
+    /// Run the task immediately in the thread that gets notified of the finished future
+    static Executor inlined() {
+        return Executor(Inline);
+    }
+
+    /// Run the task in the main thread. It is dropped if the application is destroyed.
+    /** Unlike context(), it doesn't connect to the application to cancel the chain, as nothing is left to observe it by then.
+     */
+    static Executor mainThread() {
+        Executor executor(Thread);
+        executor.m_target = QCoreApplication::instance();
+        return executor;
+    }
+
+    /// Run the task by the dispatcher of the calling thread.
+    /** It is the main thread for the main thread, the event loop of a thread running one, or a shared background
+     *  thread for the other worker threads. So a chain built on a worker thread does not wait for a busy main thread.
+     */
+    static Executor dispatcher() {
+        Executor executor(Thread);
+        executor.m_target = Private::Dispatcher::current();
+        return executor;
+    }
+
+    /// Run the task in the thread of a context object. It is dropped and the chain is canceled if the context object is destroyed.
+    static Executor context(const QObject* contextObject) {
+        Executor executor(Context);
+        executor.m_target = contextObject;
+        return executor;
+    }
+
+    /// Run the task by the event loop of a thread. Create it once and reuse it, it allocates a receiver object in the thread.
+    static Executor thread(QThread* thread) {
+        QObject* receiver = new QObject();
+        receiver->moveToThread(thread);
+
+        Executor executor(Thread);
+        executor.m_receiver = QSharedPointer<QObject>(receiver, &QObject::deleteLater);
+        executor.m_target = receiver;
+        return executor;
+    }
+
+    /// Run the task by a QThreadPool
+    static Executor threadPool(QThreadPool* pool = QThreadPool::globalInstance()) {
+        Executor executor(ThreadPool);
+        executor.m_pool = pool;
+        return executor;
+    }
+
+    template <typename F>
+    void post(F func) const {
+        switch (m_kind) {
+        case Inline:
+            func();
+            break;
+        case Context:
+        case Thread:
+            // The task is dropped if the context object is destroyed
+            if (!m_target.isNull()) {
+                Private::runInThread(m_target.data(), std::move(func));
+            }
+            break;
+        case ThreadPool:
+            if (!m_pool.isNull()) {
+                m_pool->start(new Private::RunnableFunction<F>(std::move(func)));
+            }
+            break;
+        case Custom:
+            m_dispatcher(Task(std::move(func)));
+            break;
+        }
+    }
+
+    /// The context object that cancels the chain once destroyed. nullptr if it is not a context executor
+    const QObject* contextObject() const {
+        return m_kind == Context ? m_target.data() : nullptr;
+    }
+
+    /// The object that the tasks are posted to. nullptr if the executor does not post to a thread.
+    const QObject* receiver() const {
+        return m_target.data();
+    }
+
+    /// True if a task posted from the calling thread would run on it
+    bool isCurrentThread() const {
+        if (m_kind == Inline) {
+            return true;
+        }
+        return !m_target.isNull() && m_target->thread() == QThread::currentThread();
+    }
+
+private:
+    enum Kind {
+        Inline,
+        Context,
+        Thread,
+        ThreadPool,
+        Custom
+    };
+
+    Executor(Kind kind) : m_kind(kind) {
+    }
+
+    Kind m_kind;
+    QPointer<const QObject> m_target;
+    QSharedPointer<QObject> m_receiver;
+    QPointer<QThreadPool> m_pool;
+    std::function<void(Task)> m_dispatcher;
+};
+
+namespace Private {
+
+/* ChainNode is a step of a chain created by execute().
+ *
+ * It is the only object allocated per step besides the DeferredFuture. It is appended to the
+ * ContinuationList of the observed future to run the callback, and to the one of the deferred future
+ * to propagate cancellation upstream. The callbacks are posted to the executor. The context object of
+ * the executor is set to cancel the deferred future once destroyed.
+ *
+ * It is reference counted by the lists and the posted callbacks.
+ */
+template <typename DeferredType, typename RetType, typename T, typename Completed, typename Canceled>
+class ChainNode : public Continuation, public QSharedData {
+public:
+    ChainNode(QFuture<T> future,
+              DeferredPointer<DeferredFuture<DeferredType>> defer,
+              Executor executor,
+              Completed onCompleted,
+              Canceled onCanceled) :
+        future(future),
+        defer(defer),
+        executor(executor),
+        onCompleted(onCompleted),
+        onCanceled(onCanceled),
+        canceled(0),
+        upstream(this) {
+    }
+
+    /// Observe the future
+    void observe() {
+        ref.ref();
+        observeFuture(future, executor.receiver(), this);
+    }
+
+    /// Observe the deferred future and the context object
+    void observeDeferred() {
+        ref.ref();
+        observeFuture(defer->future(), executor.receiver(), &upstream);
+
+        if (executor.contextObject()) {
+            defer->cancel(executor.contextObject(), &QObject::destroyed);
+        }
+    }
+
+    // The future is finished
+    void complete() {
+        try {
+            Value<RetType> value = eval(onCompleted, future);
+            defer->complete(std::move(value));
+        } catch (QException& e) {
+            defer->reportException(e);
+            defer->cancel();
+        } catch (...) {
+            defer->reportException(QUnhandledException());
+            defer->cancel();
+        }
+    }
+
+    // The future is canceled
+    void cancel() {
+        cancelOnce();
+        defer->cancel();
+    }
+
+    // The deferred future is canceled. Propagate it to the observed future
+    void cancelUpstream() {
+        cancelOnce();
+        cancelFuture(future);
+    }
+
+    void settle(bool isCanceled) {
+        QExplicitlySharedDataPointer<ChainNode> node(this);
+
+        post([node, isCanceled]() {
+            if (isCanceled) {
+                node->cancel();
+            } else {
+                node->complete();
+            }
+            node->releaseDeferred();
+        });
+    }
+
+    void progressValueChanged(int value) {
+        defer->setParentProgressValue(value);
+    }
+
+    void progressRangeChanged(int min, int max) {
+        defer->setParentProgressRange(min, max);
+    }
+
+    void release() {
+        if (!ref.deref()) {
+            delete this;
+        }
+    }
+
+    /// Drop the reference to the deferred future once it is completed/canceled by this node.
+    /** Otherwise, the node could destroy the deferred future when it is released by its ContinuationList.
+     */
+    void releaseDeferred() {
+        defer.clear();
+    }
+
+private:
+    class Upstream : public Continuation {
+    public:
+        Upstream(ChainNode* node) : node(node) {
+        }
+
+        void settle(bool isCanceled) {
+            if (!isCanceled) {
+                return;
+            }
 
-/* eval() : Evaluate the expression - "return functor(future)" that may have a void return type */
+            QExplicitlySharedDataPointer<ChainNode> chainNode(node);
 
-template <typename Functor, typename T>
-typename std::enable_if<ret_type_is_void<Functor>::value && arg_count_is_zero<Functor>::value,
-Value<RetType<Functor>>>::type
-eval(Functor functor, QFuture<T> future) {
-    Q_UNUSED(future);
-    functor();
-    return Value<void>();
-}
+            node->post([chainNode]() {
+                chainNode->cancelUpstream();
+            });
+        }
 
-template <typename Functor, typename T>
-typename std::enable_if<ret_type_is_void<Functor>::value && !arg_count_is_zero<Functor>::value,
-Value<RetType<Functor>>>::type
-eval(Functor functor, QFuture<T> future) {
-    // callIgnoreReturn() is designed to reduce the no. of annoying compiler error messages.
-    callIgnoreReturn(functor, future);
-    return Value<void>();
-}
+        void progressValueChanged(int) {
+        }
 
-template <typename Functor, typename T>
-typename std::enable_if<!ret_type_is_void<Functor>::value && arg_count_is_zero<Functor>::value,
-Value<RetType<Functor>>>::type
-eval(Functor functor, QFuture<T> future) {
-    Q_UNUSED(future);
-    return functor();
-}
+        void progressRangeChanged(int, int) {
+        }
 
-template <typename Functor, typename T>
-typename std::enable_if<!ret_type_is_void<Functor>::value && !arg_count_is_zero<Functor>::value,
-Value<RetType<Functor>>>::type
-eval(Functor functor, QFuture<T> future) {
-    return call(functor, future);
-}
+        void release() {
+            node->release();
+        }
 
-template <typename Canceled>
-class CancelOnce {
-public:
-    CancelOnce(Canceled onCanceled) :
-        onCanceled(onCanceled)
-    {}
+        ChainNode* node;
+    };
 
-    void cancel() {
-        if(!canceled) {
-            canceled = true;
+    QFuture<T> future;
+    DeferredPointer<DeferredFuture<DeferredType>> defer;
+    Executor executor;
+    Completed onCompleted;
+    Canceled onCanceled;
+    // The observed future and the deferred future could be canceled at the same time
+    QAtomicInt canceled;
+    Upstream upstream;
+
+    void cancelOnce() {
+        if (canceled.testAndSetOrdered(0, 1)) {
             onCanceled();
         }
     }
 
-    Canceled onCanceled;
-    bool canceled = false;
+    template <typename F>
+    void post(F func) {
+        executor.post(std::move(func));
+    }
 };
 
 /// Create a DeferredFuture that will execute the callback functions when observed future finished
@@ -1249,57 +3445,53 @@ public:
  *
  * DeferredType and RetType can be different.
  * e.g DeferredFuture<int> = Value<QFuture<int>>
+ *
+ * If inlineIfReady is true and the future is already finished, the callback is executed immediately
+ * provided that the executor runs tasks on the calling thread.
+ *
+ * The progress forwarded to the returned future is coalesced by progressCoalescing.
  */
 template <typename DeferredType, typename RetType, typename T, typename Completed, typename Canceled>
-static QFuture<DeferredType> execute(QFuture<T> future, const QObject* contextObject, Completed onCompleted, Canceled onCanceled) {
+static QFuture<DeferredType> execute(QFuture<T> future,
+                                     Executor executor,
+                                     Completed onCompleted,
+                                     Canceled onCanceled,
+                                     bool inlineIfReady = false,
+                                     ProgressCoalescing progressCoalescing = ProgressCoalescing()) {
 
     auto defer = DeferredFuture<DeferredType>::create();
 
+    if (progressCoalescing.mode() != ProgressCoalescing::None) {
+        defer->setProgressCoalescing(progressCoalescing);
+    }
+
     defer->setParentProgressValue(future.progressValue());
     defer->setParentProgressRange(future.progressMinimum(), future.progressMaximum());
 
-    auto cancelOnce = QSharedPointer<CancelOnce<Canceled>>::create(onCanceled);
+    QExplicitlySharedDataPointer<ChainNode<DeferredType, RetType, T, Completed, Canceled>> node(
+                new ChainNode<DeferredType, RetType, T, Completed, Canceled>(future, defer, executor, onCompleted, onCanceled));
 
-    watch(future,
-          contextObject,
-          contextObject,[=]() {
-        try {
-            Value<RetType> value = eval(onCompleted, future);
-            defer->complete(value);
-        } catch (QException& e) {
-            defer->reportException(e);
-            defer->cancel();
-        } catch (...) {
-            defer->reportException(QUnhandledException());
-            defer->cancel();
-        }
-    }, [=]() {
-        cancelOnce->cancel();
-        defer->cancel();
-    }, [=](int progressValue) {
-        defer->setParentProgressValue(progressValue);
-    }, [=](int min, int max) {
-        defer->setParentProgressRange(min, max);
-    });
+    if (inlineIfReady &&
+        future.isFinished() &&
+        executor.isCurrentThread()) {
 
-    if (contextObject) {
-        defer->cancel(contextObject, &QObject::destroyed);
-    }
+        if (future.isCanceled()) {
+            node->cancel();
+        } else {
+            node->complete();
+        }
 
+        if (defer->isFinished()) {
+            // Nothing left to observe
+            return defer->future();
+        }
 
-    //Watch the defer future and propgate changes up to the parent future
-    auto futurePtr = QSharedPointer<QFuture<void>>::create(future);
-    watch(defer->future(),
-          contextObject,
-          contextObject,
-          []() {}, //onComplete
-    [futurePtr, cancelOnce]() {
-        cancelOnce->cancel();
-        futurePtr->cancel();
-    },
-    [](int){},
-    [](int,int){}
-    );
+        node->observeDeferred();
+        node->releaseDeferred();
+    } else {
+        node->observeDeferred();
+        node->observe();
+    }
 
     return defer->future();
 }
@@ -1315,21 +3507,42 @@ template <typename T>
 class Observable {
 protected:
     QFuture<T> m_future;
+    bool m_inlineIfReady;
+    ProgressCoalescing m_progressCoalescing;
 
 public:
 
-    Observable() {
+    Observable() : m_inlineIfReady(false) {
 
     }
 
-    Observable(QFuture<T> future) {
+    Observable(QFuture<T> future) : m_inlineIfReady(false) {
         m_future = future;
     }
 
     QFuture<T> future() const {
+        Private::exposeFuture(m_future);
         return m_future;
     }
 
+    /// Execute the callback of subscribe() / context() / then() immediately on the calling thread if the future is already finished.
+    /** It only takes effect if the executor runs tasks on the calling thread (main thread for subscribe()).
+     *  Otherwise, the callback is posted to the executor as usual.
+     *  The mode is inherited by the Observable returned from subscribe() / context() / then().
+     */
+    Observable<T>& inlineIfReady(bool value = true) {
+        m_inlineIfReady = value;
+        return *this;
+    }
+
+    /// Coalesce the progress delivered to onProgress() and the futures returned by subscribe() / context() / then().
+    /** The mode is inherited by the Observable returned from subscribe() / context() / then().
+     */
+    Observable<T>& coalesceProgress(ProgressCoalescing value) {
+        m_progressCoalescing = value;
+        return *this;
+    }
+
     template <typename Completed>
     typename std::enable_if< !Private::future_traits<typename Private::function_traits<Completed>::result_type>::is_future,
     Observable<typename Private::function_traits<Completed>::result_type>
@@ -1339,9 +3552,7 @@ public:
 
         ASYNC_FUTURE_CALLBACK_STATIC_ASSERT("context(callback): ", Completed);
 
-        return _context<typename Private::function_traits<Completed>::result_type,
-                       typename Private::function_traits<Completed>::result_type
-                >(contextObject, functor, [](){});
+        return then(Executor::context(contextObject), functor);
     }
 
     template <typename Completed>
@@ -1353,9 +3564,7 @@ public:
 
         ASYNC_FUTURE_CALLBACK_STATIC_ASSERT("context(callback): ", Completed);
 
-        return _context<typename Private::future_traits<typename Private::function_traits<Completed>::result_type>::arg_type,
-                       typename Private::function_traits<Completed>::result_type
-                >(contextObject, functor, [](){});
+        return then(Executor::context(contextObject), functor);
     }
 
     template <typename Completed, typename Canceled>
@@ -1367,9 +3576,7 @@ public:
 
         ASYNC_FUTURE_CALLBACK_STATIC_ASSERT("context(callback): ", Completed);
 
-        return _context<typename Private::function_traits<Completed>::result_type,
-                typename Private::function_traits<Completed>::result_type
-                >(contextObject, onCompleted, onCanceled);
+        return then(Executor::context(contextObject), onCompleted, onCanceled);
     }
 
     template <typename Completed, typename Canceled>
@@ -1381,11 +3588,69 @@ public:
 
         ASYNC_FUTURE_CALLBACK_STATIC_ASSERT("context(callback): ", Completed);
 
-        return _context<typename Private::future_traits<typename Private::function_traits<Completed>::result_type>::arg_type,
+        return then(Executor::context(contextObject), onCompleted, onCanceled);
+    }
+
+    /* then function */
+
+    template <typename Completed>
+    typename std::enable_if< !Private::future_traits<typename Private::function_traits<Completed>::result_type>::is_future,
+    Observable<typename Private::function_traits<Completed>::result_type>
+    >::type
+    then(Executor executor, Completed functor)  {
+        /* functor return non-QFuture type */
+
+        ASYNC_FUTURE_CALLBACK_STATIC_ASSERT("then(callback): ", Completed);
+
+        return _then<typename Private::function_traits<Completed>::result_type,
+                    typename Private::function_traits<Completed>::result_type
+                >(executor, functor, [](){});
+    }
+
+    template <typename Completed>
+    typename std::enable_if< Private::future_traits<typename Private::function_traits<Completed>::result_type>::is_future,
+    Observable<typename Private::future_traits<typename Private::function_traits<Completed>::result_type>::arg_type>
+    >::type
+    then(Executor executor, Completed functor)  {
+        /* functor returns a QFuture */
+
+        ASYNC_FUTURE_CALLBACK_STATIC_ASSERT("then(callback): ", Completed);
+
+        return _then<typename Private::future_traits<typename Private::function_traits<Completed>::result_type>::arg_type,
+                    typename Private::function_traits<Completed>::result_type
+                >(executor, functor, [](){});
+    }
+
+    template <typename Completed, typename Canceled>
+    typename std::enable_if< !Private::future_traits<typename Private::function_traits<Completed>::result_type>::is_future,
+    Observable<typename Private::function_traits<Completed>::result_type>
+    >::type
+    then(Executor executor, Completed onCompleted, Canceled onCanceled)  {
+        /* functor return non-QFuture type */
+
+        ASYNC_FUTURE_CALLBACK_STATIC_ASSERT("then(callback): ", Completed);
+
+        return _then<typename Private::function_traits<Completed>::result_type,
                 typename Private::function_traits<Completed>::result_type
-                >(contextObject, onCompleted, onCanceled);
+                >(executor, onCompleted, onCanceled);
     }
 
+    template <typename Completed, typename Canceled>
+    typename std::enable_if< Private::future_traits<typename Private::function_traits<Completed>::result_type>::is_future,
+    Observable<typename Private::future_traits<typename Private::function_traits<Completed>::result_type>::arg_type>
+    >::type
+    then(Executor executor, Completed onCompleted, Canceled onCanceled)  {
+        /* functor returns a QFuture */
+
+        ASYNC_FUTURE_CALLBACK_STATIC_ASSERT("then(callback): ", Completed);
+
+        return _then<typename Private::future_traits<typename Private::function_traits<Completed>::result_type>::arg_type,
+                typename Private::function_traits<Completed>::result_type
+                >(executor, onCompleted, onCanceled);
+    }
+
+    /* end of then function */
+
     /* subscribe function */
 
     template <typename Completed, typename Canceled>
@@ -1470,8 +3735,31 @@ public:
             }
         };
 
+        QSharedPointer<Private::ProgressGate> gate;
+        if (m_progressCoalescing.mode() != ProgressCoalescing::None) {
+            gate = QSharedPointer<Private::ProgressGate>::create();
+            gate->setCoalescing(m_progressCoalescing);
+        }
+
+        auto onValueChanged = [=](int value) mutable {
+            auto flush = [=]() mutable {
+                int pending;
+                if (gate->flushed(&pending)) {
+                    wrapper();
+                }
+            };
+
+            if (gate.isNull() || gate->pass(value, watcher->progressMaximum(), watcher, flush)) {
+                wrapper();
+            }
+        };
+
         QObject::connect(watcher, &QFutureWatcher<T>::finished,
-                         [=]() {
+                         [=]() mutable {
+            int pending;
+            if (!gate.isNull() && gate->takePending(&pending)) {
+                wrapper();
+            }
             watcher->disconnect();
             watcher->deleteLater();
         });
@@ -1482,13 +3770,15 @@ public:
             watcher->deleteLater();
         });
 
-        QObject::connect(watcher, &QFutureWatcher<T>::progressValueChanged, wrapper);
+        QObject::connect(watcher, &QFutureWatcher<T>::progressValueChanged, onValueChanged);
 
         QObject::connect(watcher, &QFutureWatcher<T>::progressRangeChanged, wrapper);
 
-        if (QThread::currentThread() != QCoreApplication::instance()->thread()) {
-            watcher->moveToThread(QCoreApplication::instance()->thread());
+        QThread* thread = Private::Dispatcher::current()->thread();
+        if (QThread::currentThread() != thread) {
+            watcher->moveToThread(thread);
         }
+        Private::Dispatcher::adopt(watcher);
 
         watcher->setFuture(m_future);
     }
@@ -1527,29 +3817,30 @@ public:
     template <typename ANY>
     void onCanceled(QFuture<ANY> future) {
         subscribe([]() {}, [=]() {
-            auto f = future;
-            f.cancel();
+            Private::cancelFuture(future);
         });
     }
 
 private:
     template <typename ObservableType, typename RetType, typename Completed, typename Canceled>
-    Observable<ObservableType> _context(const QObject* contextObject, Completed onCompleted, Canceled onCanceled)  {
+    Observable<ObservableType> _then(Executor executor, Completed onCompleted, Canceled onCanceled)  {
 
         auto future = Private::execute<ObservableType, RetType>(m_future,
-                                                               contextObject,
+                                                               executor,
                                                                onCompleted,
-                                                               onCanceled);
+                                                               onCanceled,
+                                                               m_inlineIfReady,
+                                                               m_progressCoalescing);
 
-        return Observable<ObservableType>(future);
+        return Observable<ObservableType>(future).inlineIfReady(m_inlineIfReady).coalesceProgress(m_progressCoalescing);
     }
 
     template <typename ObservableType, typename RetType, typename Completed, typename Canceled>
     Observable<ObservableType> _subscribe(Completed onCompleted, Canceled onCanceled) {       
 
-        return _context<ObservableType, RetType, Completed, Canceled>(QCoreApplication::instance(),
-                                                                      onCompleted,
-                                                                      onCanceled);
+        return _then<ObservableType, RetType, Completed, Canceled>(Executor::dispatcher(),
+                                                                   onCompleted,
+                                                                   onCanceled);
     }
 
 };
@@ -1573,11 +3864,11 @@ public:
 
     void complete(T value)
     {
-        deferredFuture->complete(value);
+        deferredFuture->complete(std::move(value));
     }
 
     void complete(QList<T> value) {
-        deferredFuture->complete(value);
+        deferredFuture->complete(std::move(value));
     }
 
     template <typename ANY>
@@ -1598,6 +3889,13 @@ public:
         deferredFuture->setProgressValue(value);
     }
 
+    /// Coalesce the progress values set by setProgressValue() or tracked from another future
+    Deferred<T>& coalesceProgress(ProgressCoalescing value) {
+        Observable<T>::coalesceProgress(value);
+        deferredFuture->setProgressCoalescing(value);
+        return *this;
+    }
+
     void setProgressRange(int minimum, int maximum) {
         deferredFuture->setProgressRange(minimum, maximum);
     }
@@ -1607,7 +3905,7 @@ public:
     }
 
 protected:
-    QSharedPointer<Private::DeferredFuture<T> > deferredFuture;
+    Private::DeferredPointer<Private::DeferredFuture<T> > deferredFuture;
 };
 
 template<>
@@ -1652,30 +3950,45 @@ public:
         deferredFuture->reportStarted();
     }
 
+    /// Coalesce the progress values tracked from another future
+    Deferred<void>& coalesceProgress(ProgressCoalescing value) {
+        Observable<void>::coalesceProgress(value);
+        deferredFuture->setProgressCoalescing(value);
+        return *this;
+    }
+
 protected:
-    QSharedPointer<Private::DeferredFuture<void> > deferredFuture;
+    Private::DeferredPointer<Private::DeferredFuture<void> > deferredFuture;
 };
 
 typedef enum {
     FailFast,
-    AllSettled
+    AllSettled,
+    FirstCompleted,
+    Quorum
 } CombinatorMode;
 
 class Combinator : public Observable<void> {
 private:
-    QSharedPointer<Private::CombinedFuture> combinedFuture;
+    Private::DeferredPointer<Private::CombinedFuture> combinedFuture;
+    int m_shardSize;
 
 public:
-    inline Combinator(CombinatorMode mode = FailFast) : Observable<void>() {
-        combinedFuture = Private::CombinedFuture::create(mode == AllSettled);
+    /// @param quorum The number of futures to be completed in Quorum mode
+    inline Combinator(CombinatorMode mode = FailFast, int quorum = 1) : Observable<void>(), m_shardSize(0) {
+        combinedFuture = Private::CombinedFuture::create(mode == AllSettled ? Private::CombinedFuture::AllSettledMode :
+                                                         mode == FirstCompleted ? Private::CombinedFuture::FirstCompletedMode :
+                                                         mode == Quorum ? Private::CombinedFuture::QuorumMode :
+                                                                          Private::CombinedFuture::FailFastMode,
+                                                         quorum);
         m_future = combinedFuture->future();
     }
 
-    inline ~Combinator() {
-        if (!combinedFuture.isNull() && combinedFuture->future().progressMaximum() == 0) {
-            // No future added
-            combinedFuture->deleteLater();
-        }
+    /// Coalesce the progress aggregated from the combined futures
+    Combinator& coalesceProgress(ProgressCoalescing value) {
+        Observable<void>::coalesceProgress(value);
+        combinedFuture->setProgressCoalescing(value);
+        return *this;
     }
 
     template <typename T>
@@ -1684,6 +3997,16 @@ public:
         return *this;
     }
 
+    /// Combine a future with a weight. Its progress is normalized to the weight, whatever its own range is.
+    /** e.g. A future reporting bytes and another reporting items take equal shares if both weights are 1000.
+     *  If the sum of the ranges exceeds the int range of QFuture, the aggregated progress is scaled into it.
+     */
+    template <typename T>
+    Combinator& combine(QFuture<T> future, qint64 weight) {
+        combinedFuture->addFuture(future, weight);
+        return *this;
+    }
+
     template <typename T>
     Combinator& operator<<(QFuture<T> future) {
         combinedFuture->addFuture(future);
@@ -1692,9 +4015,34 @@ public:
 
     template <typename T>
     Combinator& operator<<(QList<QFuture<T>> futures) {
-        for(auto future : futures) {
-            combinedFuture->addFuture(future);
-        }
+        combinedFuture->addFuturesSharded(futures, m_shardSize);
+        return *this;
+    }
+
+    /// Add futures created by factories, keeping at most maxInFlight of them unsettled.
+    /** Each factory is a callable returning a QFuture. The next one is called as a future settles. They are
+     *  not called anymore once the combined future is finished, e.g. canceled by a future in FailFast mode.
+     */
+    template <typename Factory>
+    Combinator& combine(QList<Factory> factories, int maxInFlight) {
+        combinedFuture->addFactories(factories, maxInFlight);
+        return *this;
+    }
+
+    /// Cancel the futures in parallel on the global thread pool if more than threshold of them are unfinished
+    Combinator& parallelCancel(int threshold = 4096) {
+        combinedFuture->setParallelCancelThreshold(threshold);
+        return *this;
+    }
+
+    /// Count the completion of large lists of futures by a tree of sub-combiners
+    /** A list added later with more than shardSize futures is split into shards. Each shard is counted
+     *  in a separated dispatcher thread, so the completion of a very large fan-in is spread across the cores.
+     *  The mode and the progress aggregation are kept. It has no effect in FirstCompleted and Quorum modes,
+     *  as they count the futures directly. 0 disables it.
+     */
+    Combinator& shard(int shardSize = 1024) {
+        m_shardSize = shardSize;
         return *this;
     }
 
@@ -1717,32 +4065,74 @@ static Observable<T> observe(QFuture<T> future) {
     return Observable<T>(future);
 }
 
+/// Observe the next emission of a signal. A signal with more than one argument is observed as a std::tuple.
+/** The tuple is built from the arguments directly, without QVariant. A queued connection still requires the
+ *  argument types to be known to the meta type system, as Qt copies them. A direct connection doesn't.
+ *  @param type The connection type. With Qt::DirectConnection or Qt::AutoConnection in the thread of the sender,
+ *  the future is completed synchronously inside the emission instead of on the next event loop pass.
+ */
 template <typename Member>
-auto observe(QObject* object, Member pointToMemberFunction)
+auto observe(QObject* object, Member pointToMemberFunction, Qt::ConnectionType type = Qt::QueuedConnection)
 -> Observable< typename Private::signal_traits<Member>::result_type> {
 
     typedef typename Private::signal_traits<Member>::result_type RetType;
 
     auto defer = Private::DeferredFuture<RetType>::create();
 
-    auto proxy = new Private::Proxy<RetType>(nullptr);
+    // Observers of the same signal share one connection
+    Private::SharedProxy<RetType, typename Private::signal_traits<Member>::arguments>::observe(
+                object, pointToMemberFunction, type, defer.data());
+
+    Observable< typename Private::signal_traits<Member>::result_type> observer(defer->future());
+    return observer;
+}
+
+/// Observe every emission of a signal. Each of them is reported as a result of the returned future.
+/** The emissions are buffered and reported in a batch once per event loop pass. If batchSize is not 0, at most
+ *  batchSize of them are kept per pass and the overflow policy applies to the next one.
+ *
+ *  It only bounds a batch. Like any QFuture, the returned one keeps every result reported to it, so its memory grows
+ *  with the number of batches. Cancel a long-lived stream and start a new one to drop them.
+ *
+ *  The future is completed once the sender is destroyed.
+ *  Canceling the future disconnects the signal and releases the stream right away. The type is the connection type.
+ *  A direct connection is only honored for emissions from the calling thread. The others are queued.
+ */
+template <typename Member>
+auto stream(QObject* object, Member pointToMemberFunction, int batchSize = 0, StreamOverflow overflow = FlushBuffer,
+            Qt::ConnectionType type = Qt::QueuedConnection)
+-> QFuture< typename Private::signal_traits<Member>::result_type> {
+
+    typedef typename Private::signal_traits<Member>::result_type RetType;
+    static_assert(!std::is_same<RetType, void>::value, "stream() requires a signal with an argument");
+
+    auto defer = Private::DeferredFuture<RetType>::create();
+    QFuture<RetType> future = defer->exposedFuture();
+
+    auto proxy = new Private::StreamProxy<RetType, typename Private::signal_traits<Member>::arguments>(defer, batchSize, overflow);
 
+    // Queued, so that the emissions queued before it are reported
     QObject::connect(object, &QObject::destroyed, proxy, [=]() {
-       defer->cancel();
-       delete proxy;
-    });
+        proxy->finish();
+    }, Qt::QueuedConnection);
 
-    proxy->bind(object, pointToMemberFunction);
-    proxy->callback = [=](Private::Value<RetType> value) {
-        defer->complete(value);
+    Private::watch(future, proxy, proxy, []() {}, [=]() {
         delete proxy;
-    };
+    }, [](int) {}, [](int, int) {});
 
-    Observable< typename Private::signal_traits<Member>::result_type> observer(defer->future());
-    return observer;
+    // The buffer is only touched by the thread of the proxy, so a direct emission from another thread must be queued
+    if (type == Qt::DirectConnection) {
+        type = Qt::AutoConnection;
+    }
+
+    proxy->bind(object, pointToMemberFunction, type);
+    proxy->disconnectOnCancel();
+
+    return future;
 }
 
-inline Observable<QVariant> observe(QObject *object,QString signal)  {
+/// Observe the next emission of a signal by its signature. The type is the connection type, as observe(object, member, type).
+inline Observable<QVariant> observe(QObject *object,QString signal, Qt::ConnectionType type = Qt::QueuedConnection)  {
 
     auto defer = Private::DeferredFuture<QVariant>::create();
 
@@ -1755,12 +4145,12 @@ inline Observable<QVariant> observe(QObject *object,QString signal)  {
        delete proxy;
     });
 
-    if (proxy->bind(object, signal)) {
-        proxy->callback = [=](QVariant value) {
-            defer->complete(value);
-            delete proxy;
-        };
-    } else {
+    proxy->callback = [=](QVariant value) {
+        defer->complete(std::move(value));
+        Private::deleteInThread(proxy);
+    };
+
+    if (!proxy->bind(object, signal, type)) {
         defer->cancel();
         delete proxy;
     }
@@ -1778,6 +4168,179 @@ inline Combinator combine(CombinatorMode mode = FailFast) {
     return Combinator(mode);
 }
 
+/// Combine futures created by factories, keeping at most maxInFlight of them unsettled.
+/** It is the bounded version of starting all of them and combining the futures.
+ *  The quorum is the number of futures that must complete when mode is Quorum. It is clamped to at least 1,
+ *  and the combined future is canceled if it is more than the number of factories.
+ */
+template <typename Factory>
+Combinator combine(QList<Factory> factories, int maxInFlight, CombinatorMode mode = FailFast, int quorum = 1) {
+    Combinator combinator(mode, quorum);
+    combinator.combine(factories, maxInFlight);
+    return combinator;
+}
+
+/// Combine futures that is completed once k of them are completed, or canceled once it is no longer possible.
+/** The rest of the futures are canceled as soon as the outcome is decided. k is at least 1. If it is more than
+ *  the number of futures added in the same event loop pass, the combined future is canceled.
+ */
+inline Combinator quorum(int k) {
+    return Combinator(Quorum, k);
+}
+
+template <typename T>
+QFuture<T> completed(const QList<T> &val);
+
+/// Combine futures into one that contains all their results in input order.
+/** It is canceled once any of the futures is canceled. Canceling it cancels the unfinished futures.
+ *  The results are forwarded in batches as Deferred<T>::complete(QFuture<T>) does.
+ */
+template <typename T>
+QFuture<T> all(QList<QFuture<T>> futures) {
+    auto defer = Private::DeferredFuture<T>::create();
+
+    if (futures.isEmpty()) {
+        defer->complete();
+        return defer->exposedFuture();
+    }
+
+    Combinator combinator(FailFast);
+    combinator << futures;
+    QFuture<void> combined = combinator.future();
+
+    observe(combined).then(Executor::inlined(), [=]() {
+        Private::reportResultsOf(defer.data(), futures);
+        defer->complete();
+    }, [=]() {
+        defer->cancel();
+    });
+
+    defer->track(combined);
+    observe(defer->future()).onCanceled(combined);
+
+    return defer->exposedFuture();
+}
+
+/// Combine futures of different types into one future of std::tuple. Each future should have a result.
+/** It is canceled once any of the futures is canceled, or finished without a result. Canceling it cancels the unfinished futures.
+ */
+template <typename... Args>
+QFuture<std::tuple<Args...>> all(QFuture<Args>... futures) {
+    static_assert(sizeof...(Args) > 0, "all() requires at least one future");
+    static_assert(!Private::any_void<Args...>::value, "all() requires futures with a result. Use combine() for QFuture<void>");
+
+    auto defer = Private::DeferredFuture<std::tuple<Args...>>::create();
+
+    Combinator combinator(FailFast);
+    int expand[] = { (combinator << futures, 0)... };
+    Q_UNUSED(expand);
+    QFuture<void> combined = combinator.future();
+
+    observe(combined).then(Executor::inlined(), [=]() {
+        if (!Private::haveResults(futures...)) {
+            defer->cancel();
+            return;
+        }
+
+        // Each result is copied once from the result store of its future, which is shared with the caller,
+        // straight into the tuple. The tuple is moved from here on.
+        defer->complete(std::tuple<Args...>(futures.d.resultReference(0)...));
+    }, [=]() {
+        defer->cancel();
+    });
+
+    defer->track(combined);
+    observe(defer->future()).onCanceled(combined);
+
+    return defer->exposedFuture();
+}
+
+/// Race the futures. The result future contains the results of the first completed future.
+/** The rest of the futures are canceled as soon as one of them is completed. It is canceled only
+ *  if all of the futures are canceled. Canceling it cancels the unfinished futures.
+ */
+template <typename T>
+QFuture<T> race(QList<QFuture<T>> futures) {
+    auto defer = Private::DeferredFuture<T>::create();
+
+    if (futures.isEmpty()) {
+        defer->cancel();
+        return defer->exposedFuture();
+    }
+
+    auto combinedFuture = Private::CombinedFuture::create(Private::CombinedFuture::FirstCompletedMode);
+    combinedFuture->addFutures(futures);
+    QFuture<void> combined = combinedFuture->future();
+
+    // The callback is executed inline while the combined future settles, or right here if it is
+    // settled already. combinedFuture is held until then() returns, so the raw pointer is valid in both cases.
+    Private::CombinedFuture* winner = combinedFuture.data();
+
+    observe(combined).then(Executor::inlined(), [=]() {
+        defer->reportResultsOf(futures[winner->winnerIndex()]);
+        defer->complete();
+    }, [=]() {
+        defer->cancel();
+    });
+
+    defer->track(combined);
+    observe(defer->future()).onCanceled(combined);
+
+    return defer->exposedFuture();
+}
+
+typedef enum {
+    CompletionOrder,
+    InputOrder
+} MergeOrder;
+
+/// Merge the results of futures into one future as each of them is completed.
+/** In CompletionOrder, the results of a future are added as soon as it is completed. In InputOrder,
+ *  they are held until the results of the futures before it are added. It is canceled once any of
+ *  the futures is canceled. Canceling it cancels the unfinished futures.
+ */
+template <typename T>
+QFuture<T> merge(QList<QFuture<T>> futures, MergeOrder order = CompletionOrder) {
+    auto defer = Private::DeferredFuture<T>::create();
+
+    if (futures.isEmpty()) {
+        defer->complete();
+        return defer->exposedFuture();
+    }
+
+    auto combinedFuture = Private::CombinedFuture::create(Private::CombinedFuture::FailFastMode);
+
+    if (order == CompletionOrder) {
+        combinedFuture->onCompletedAt([=](int index) {
+            defer->reportResultsOf(futures[index]);
+        });
+    } else {
+        QVector<bool> ready(futures.size(), false);
+        int next = 0;
+
+        combinedFuture->onCompletedAt([=](int index) mutable {
+            ready[index] = true;
+            while (next < futures.size() && ready[next]) {
+                defer->reportResultsOf(futures[next]);
+                next++;
+            }
+        });
+    }
+
+    combinedFuture->addFutures(futures);
+    QFuture<void> combined = combinedFuture->future();
+
+    observe(combined).then(Executor::inlined(), [=]() {
+        defer->complete();
+    }, [=]() {
+        defer->cancel();
+    });
+
+    defer->track(combined);
+    observe(defer->future()).onCanceled(combined);
+
+    return defer->exposedFuture();
+}
 
 inline QFuture<void> completed() {
    QFutureInterface<void> fi;
@@ -0,0 +1,46 @@
+#include <cstdlib>
+#include <new>
+#include "allocationcounter.h"
+
+static thread_local bool s_counting = false;
+static thread_local int s_count = 0;
+
+void* operator new(std::size_t size)
+{
+    if (s_counting) {
+        s_count++;
+    }
+
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+AllocationCounter::AllocationCounter() : m_count(0)
+{
+
+}
+
+void AllocationCounter::start()
+{
+    s_count = 0;
+    s_counting = true;
+}
+
+void AllocationCounter::stop()
+{
+    s_counting = false;
+    m_count = s_count;
+}
+
+int AllocationCounter::count() const
+{
+    return m_count;
+}
@@ -0,0 +1,21 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+/// Count the no. of heap allocations made by operator new on the calling thread between start() and stop()
+
+class AllocationCounter
+{
+public:
+    AllocationCounter();
+
+    void start();
+
+    void stop();
+
+    int count() const;
+
+private:
+    int m_count;
+};
+
+#endif // ALLOCATIONCOUNTER_H
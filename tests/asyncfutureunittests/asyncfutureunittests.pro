@@ -20,7 +20,9 @@ SOURCES +=     main.cpp \
     cookbook.cpp \
     testclass.cpp \
     trackingdata.cpp \
-    spec.cpp
+    spec.cpp \
+    benchmarktests.cpp \
+    allocationcounter.cpp
 
 DEFINES += SRCDIR=\\\"$$PWD/\\\" QUICK_TEST_SOURCE_DIR=\\\"$$PWD/qmltests\\\"
 
@@ -42,7 +44,9 @@ HEADERS += \
     cookbook.h \
     trackingdata.h \
     spec.h \
-    tools.h
+    tools.h \
+    benchmarktests.h \
+    allocationcounter.h
 
 #!win32 {
 #    QMAKE_CXXFLAGS += -Werror
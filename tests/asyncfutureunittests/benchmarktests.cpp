@@ -0,0 +1,548 @@
+#include <QTest>
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <asyncfuture.h>
+#include "testfunctions.h"
+#include "benchmarktests.h"
+#include "spec.h"
+
+using namespace AsyncFuture;
+using namespace Test;
+
+BenchmarkTests::BenchmarkTests(QObject *parent) : QObject(parent)
+{
+    // This function do nothing but could make Qt Creator Autotests plugin recognize this test
+    auto ref =[=]() {
+        QTest::qExec(this, 0, 0);
+    };
+    Q_UNUSED(ref);
+}
+
+void BenchmarkTests::benchmark_cache_hit_chain_data()
+{
+    QTest::addColumn<bool>("inlineIfReady");
+
+    QTest::newRow("queued") << false;
+    QTest::newRow("inlineIfReady") << true;
+}
+
+void BenchmarkTests::benchmark_cache_hit_chain()
+{
+    QFETCH(bool, inlineIfReady);
+
+    // A cache hit returns an already finished future
+    QFuture<int> cached = completed<int>(10);
+
+    QBENCHMARK {
+        auto future = observe(cached).inlineIfReady(inlineIfReady).subscribe([](int value) {
+            return value + 1;
+        }).subscribe([](int value) {
+            return value * 2;
+        }).subscribe([](int value) {
+            return QString::number(value);
+        }).future();
+
+        await(future);
+        QCOMPARE(future.result(), QString("22"));
+    }
+}
+
+void BenchmarkTests::benchmark_deferred_contention_data()
+{
+    QTest::addColumn<int>("threadCount");
+
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("2 threads") << 2;
+    QTest::newRow("4 threads") << 4;
+    QTest::newRow("8 threads") << 8;
+}
+
+void BenchmarkTests::benchmark_deferred_contention()
+{
+    QFETCH(int, threadCount);
+
+    // Many observers share a few deferred futures and update them at the same time
+    const int deferredCount = 16;
+    const int iterations = 10000;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount);
+
+    QBENCHMARK {
+        QList<Private::DeferredPointer<Private::DeferredFuture<int>>> deferreds;
+        for (int i = 0 ; i < deferredCount ; i++) {
+            deferreds << Private::DeferredFuture<int>::create();
+        }
+
+        QList<QFuture<void>> workers;
+        for (int i = 0 ; i < threadCount ; i++) {
+            workers << QtConcurrent::run(&pool, [=]() {
+                for (int j = 0 ; j < iterations ; j++) {
+                    auto defer = deferreds[(i + j) % deferredCount];
+                    defer->incWeakRefCount();
+                    defer->setParentProgressRange(0, iterations);
+                    defer->setParentProgressValue(j);
+                    defer->decWeakRefCount();
+                }
+            });
+        }
+
+        for (int i = 0 ; i < workers.size() ; i++) {
+            await(workers[i]);
+        }
+
+        for (int i = 0 ; i < deferredCount ; i++) {
+            deferreds[i]->complete(i);
+            QCOMPARE(deferreds[i]->future().result(), i);
+            QVERIFY(deferreds[i]->future().progressMaximum() == iterations);
+        }
+    }
+}
+
+void BenchmarkTests::benchmark_deferred_shared_lifecycle_data()
+{
+    QTest::addColumn<int>("threadCount");
+
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("2 threads") << 2;
+    QTest::newRow("4 threads") << 4;
+    QTest::newRow("8 threads") << 8;
+}
+
+void BenchmarkTests::benchmark_deferred_shared_lifecycle()
+{
+    QFETCH(int, threadCount);
+
+    // Every thread observes, completes and drops the same deferred futures at the same time.
+    // Only the first completion takes effect, and each observer is called exactly once.
+    const int deferredCount = 1000;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount);
+
+    QBENCHMARK {
+        QList<Private::DeferredPointer<Private::DeferredFuture<int>>> deferreds;
+        for (int i = 0 ; i < deferredCount ; i++) {
+            deferreds << Private::DeferredFuture<int>::create();
+        }
+
+        QAtomicInt called;
+        QAtomicInt sum;
+
+        QList<QFuture<void>> workers;
+        for (int i = 0 ; i < threadCount ; i++) {
+            workers << QtConcurrent::run(&pool, [=, &called, &sum]() {
+                for (int j = 0 ; j < deferredCount ; j++) {
+                    auto defer = deferreds[j];
+
+                    observe(defer->future()).then(Executor::inlined(), [&called, &sum](int value) {
+                        called.ref();
+                        sum.fetchAndAddOrdered(value);
+                    });
+
+                    defer->complete(j);
+                }
+            });
+        }
+
+        // The main thread drops its references while the workers are running
+        deferreds.clear();
+
+        for (int i = 0 ; i < workers.size() ; i++) {
+            await(workers[i]);
+        }
+
+        QCOMPARE(called.loadAcquire(), deferredCount * threadCount);
+        QCOMPARE(sum.loadAcquire(), threadCount * deferredCount * (deferredCount - 1) / 2);
+    }
+}
+
+void BenchmarkTests::benchmark_worker_chain_latency_main_blocked_data()
+{
+    QTest::addColumn<bool>("useSubscribe");
+
+    QTest::newRow("then(threadPool)") << false;
+    QTest::newRow("subscribe") << true;
+}
+
+void BenchmarkTests::benchmark_worker_chain_latency_main_blocked()
+{
+    QFETCH(bool, useSubscribe);
+
+    // A pipeline is built and completed on worker threads while the main thread is blocked.
+    // It must not wait for the main event loop, neither with an explicit executor nor with subscribe().
+    QThreadPool pool;
+
+    auto pipeline = [&]() {
+        QFuture<int> source = QtConcurrent::run(&pool, []() {
+            return 1;
+        });
+
+        QFuture<int> future;
+
+        if (useSubscribe) {
+            future = observe(source).subscribe([](int value) {
+                return value + 1;
+            }).subscribe([](int value) {
+                return value * 2;
+            }).future();
+        } else {
+            future = observe(source).then(Executor::threadPool(&pool), [](int value) {
+                return value + 1;
+            }).then(Executor::threadPool(&pool), [](int value) {
+                return value * 2;
+            }).future();
+        }
+
+        auto defer = deferred<int>();
+        defer.complete(future);
+        return defer.future();
+    };
+
+    QBENCHMARK {
+        QFuture<QFuture<int>> started = QtConcurrent::run(&pool, pipeline);
+        started.waitForFinished();
+        QFuture<int> future = started.result();
+
+        // Block the main thread without processing events
+        QElapsedTimer timer;
+        timer.start();
+        while (!future.isFinished() && timer.elapsed() < 5000) {
+            QThread::yieldCurrentThread();
+        }
+
+        QVERIFY(future.isFinished());
+        QCOMPARE(future.result(), 4);
+    }
+}
+
+void BenchmarkTests::benchmark_progress_coalescing_data()
+{
+    QTest::addColumn<int>("mode");
+    QTest::addColumn<int>("amount");
+
+    QTest::newRow("none") << (int) ProgressCoalescing::None << 0;
+    QTest::newRow("interval 50ms") << (int) ProgressCoalescing::Interval << 50;
+    QTest::newRow("delta 1%") << (int) ProgressCoalescing::Delta << 1000;
+    QTest::newRow("eventLoopPass") << (int) ProgressCoalescing::EventLoopPass << 0;
+}
+
+void BenchmarkTests::benchmark_progress_coalescing()
+{
+    QFETCH(int, mode);
+    QFETCH(int, amount);
+
+    ProgressCoalescing coalescing;
+    switch (mode) {
+    case ProgressCoalescing::Interval:
+        coalescing = ProgressCoalescing::interval(amount);
+        break;
+    case ProgressCoalescing::Delta:
+        coalescing = ProgressCoalescing::delta(amount);
+        break;
+    case ProgressCoalescing::EventLoopPass:
+        coalescing = ProgressCoalescing::eventLoopPass();
+        break;
+    default:
+        break;
+    }
+
+    const int count = 100000;
+
+    auto defer = deferred<int>();
+    defer.setProgressRange(0, count);
+    defer.coalesceProgress(coalescing);
+
+    auto observable = defer.subscribe([](int value) {
+        return value;
+    }).subscribe([](int value) {
+        return value;
+    });
+
+    int events = 0;
+    observable.onProgress([&]() {
+        events++;
+    });
+
+    auto worker = QtConcurrent::run([=]() {
+        auto d = defer;
+        for (int i = 1 ; i <= count ; i++) {
+            d.setProgressValue(i);
+        }
+        d.complete(count);
+    });
+
+    await(worker);
+    QVERIFY(waitUntil(observable.future(), 5000));
+    QCoreApplication::processEvents();
+
+    QCOMPARE(observable.future().progressValue(), count);
+    QTest::setBenchmarkResult(events, QTest::Events);
+}
+
+void BenchmarkTests::benchmark_complete_by_future_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<bool>("batched");
+
+    QList<int> counts;
+    counts << 1 << 100 << 10000 << 100000;
+
+    for (int i = 0 ; i < counts.size() ; i++) {
+        int count = counts[i];
+        QTest::newRow(QString("%1 single results").arg(count).toLocal8Bit().constData()) << count << false;
+        QTest::newRow(QString("%1 mapped results").arg(count).toLocal8Bit().constData()) << count << true;
+    }
+}
+
+void BenchmarkTests::benchmark_complete_by_future()
+{
+    QFETCH(int, count);
+    QFETCH(bool, batched);
+
+    QFuture<int> source;
+
+    if (batched) {
+        QList<int> input;
+        for (int i = 0 ; i < count ; i++) {
+            input << i;
+        }
+
+        std::function<int (int)> func = [](int value) -> int {
+            return value * 2;
+        };
+        source = QtConcurrent::mapped(input, func);
+    } else {
+        // Results are reported one by one
+        QFutureInterface<int> fi;
+        fi.reportStarted();
+        for (int i = 0 ; i < count ; i++) {
+            fi.reportResult(i * 2, i);
+        }
+        fi.reportFinished();
+        source = fi.future();
+    }
+
+    await(source);
+    QCOMPARE(source.resultCount(), count);
+
+    QBENCHMARK {
+        auto defer = deferred<int>();
+        defer.complete(source);
+        await(defer.future());
+
+        QCOMPARE(defer.future().resultCount(), count);
+        QCOMPARE(defer.future().resultAt(count - 1), (count - 1) * 2);
+    }
+}
+
+void BenchmarkTests::benchmark_combine_progress()
+{
+    // Every child progress update is aggregated by the combinator
+    const int count = 10000;
+    const int steps = 10;
+
+    QBENCHMARK {
+        QList<Deferred<int>> defers;
+        auto combinator = combine();
+
+        for (int i = 0 ; i < count ; i++) {
+            auto defer = deferred<int>();
+            defer.setProgressRange(0, steps);
+            combinator << defer;
+            defers << defer;
+        }
+
+        for (int step = 1 ; step <= steps ; step++) {
+            for (int i = 0 ; i < count ; i++) {
+                defers[i].setProgressValue(step);
+            }
+            QCoreApplication::processEvents();
+        }
+
+        for (int i = 0 ; i < count ; i++) {
+            defers[i].complete(i);
+        }
+
+        QVERIFY(waitUntil(combinator.future(), 10000));
+        QCOMPARE(combinator.future().progressValue(), count * steps);
+    }
+}
+
+void BenchmarkTests::benchmark_combine_batch_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<bool>("batched");
+
+    QList<int> counts;
+    counts << 100 << 10000;
+
+    for (int i = 0 ; i < counts.size() ; i++) {
+        int count = counts[i];
+        QTest::newRow(QString("%1 one by one").arg(count).toLocal8Bit().constData()) << count << false;
+        QTest::newRow(QString("%1 batched").arg(count).toLocal8Bit().constData()) << count << true;
+    }
+}
+
+void BenchmarkTests::benchmark_combine_batch()
+{
+    QFETCH(int, count);
+    QFETCH(bool, batched);
+
+    QList<QFuture<int>> futures;
+    for (int i = 0 ; i < count ; i++) {
+        futures << QtConcurrent::run([=]() {
+            return i;
+        });
+    }
+    QThreadPool::globalInstance()->waitForDone();
+
+    QBENCHMARK {
+        auto combinator = combine();
+
+        if (batched) {
+            combinator << futures;
+        } else {
+            for (int i = 0 ; i < count ; i++) {
+                combinator << futures[i];
+            }
+        }
+
+        QVERIFY(waitUntil(combinator.future(), 10000));
+    }
+}
+
+void BenchmarkTests::benchmark_combine_shard_data()
+{
+    QTest::addColumn<int>("producers");
+    QTest::addColumn<int>("shardSize");
+
+    QList<int> producers;
+    producers << 1 << 2 << 4 << 8 << 16 << 32 << 64;
+
+    for (int i = 0 ; i < producers.size() ; i++) {
+        int count = producers[i];
+        QTest::newRow(QString("%1 producers flat").arg(count).toLocal8Bit().constData()) << count << 0;
+        QTest::newRow(QString("%1 producers sharded").arg(count).toLocal8Bit().constData()) << count << 1024;
+    }
+}
+
+void BenchmarkTests::benchmark_combine_shard()
+{
+    // Completion throughput of a large fan-in completed by many producer threads
+    QFETCH(int, producers);
+    QFETCH(int, shardSize);
+
+    const int count = 100000;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(producers);
+
+    QBENCHMARK {
+        QList<Deferred<int>> defers;
+        QList<QFuture<int>> futures;
+        for (int i = 0 ; i < count ; i++) {
+            auto defer = deferred<int>();
+            defers << defer;
+            futures << defer.future();
+        }
+
+        auto combinator = combine();
+        combinator.shard(shardSize) << futures;
+
+        for (int p = 0 ; p < producers ; p++) {
+            QtConcurrent::run(&pool, [=]() {
+                for (int i = p ; i < count ; i += producers) {
+                    Deferred<int> defer = defers[i];
+                    defer.complete(i);
+                }
+            });
+        }
+
+        QVERIFY(waitUntil(combinator.future(), 60000));
+        QCOMPARE(combinator.future().isCanceled(), false);
+        pool.waitForDone();
+    }
+}
+
+void BenchmarkTests::benchmark_combine_cancel_latency_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<int>("threshold");
+
+    QList<int> counts;
+    counts << 1000 << 100000;
+
+    for (int i = 0 ; i < counts.size() ; i++) {
+        int count = counts[i];
+        QTest::newRow(QString("%1 sequential").arg(count).toLocal8Bit().constData()) << count << 0;
+        QTest::newRow(QString("%1 parallel").arg(count).toLocal8Bit().constData()) << count << 4096;
+    }
+}
+
+void BenchmarkTests::benchmark_combine_cancel_latency()
+{
+    // The time from canceling a combined future until all of its futures are canceled
+    QFETCH(int, count);
+    QFETCH(int, threshold);
+
+    QList<Deferred<int>> defers;
+    QList<QFuture<int>> futures;
+    for (int i = 0 ; i < count ; i++) {
+        auto defer = deferred<int>();
+        defers << defer;
+        futures << defer.future();
+    }
+
+    auto combinator = combine();
+    combinator.parallelCancel(threshold) << futures;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    combinator.future().cancel();
+
+    int canceled = 0;
+    while (canceled < count && timer.elapsed() < 60000) {
+        QCoreApplication::processEvents();
+        while (canceled < count && defers[canceled].future().isCanceled()) {
+            canceled++;
+        }
+    }
+
+    qint64 elapsed = timer.nsecsElapsed();
+    QCOMPARE(canceled, count);
+
+    QTest::setBenchmarkResult(elapsed / 1000000.0, QTest::WalltimeMilliseconds);
+}
+
+void BenchmarkTests::benchmark_observe_signal_data()
+{
+    QTest::addColumn<bool>("bySignature");
+
+    QTest::newRow("signature") << true;
+    QTest::newRow("pointer to member") << false;
+}
+
+void BenchmarkTests::benchmark_observe_signal()
+{
+    // Observe a signal in a tight loop
+    QFETCH(bool, bySignature);
+
+    const int count = 1000;
+    SignalProxy proxy;
+
+    QBENCHMARK {
+        for (int i = 0 ; i < count ; i++) {
+            if (bySignature) {
+                QFuture<QVariant> future = observe(&proxy, SIGNAL(proxy1(int))).future();
+                emit proxy.proxy1(i);
+                QVERIFY(waitUntil(future, 1000));
+            } else {
+                QFuture<int> future = observe(&proxy, &SignalProxy::proxy1).future();
+                emit proxy.proxy1(i);
+                QVERIFY(waitUntil(future, 1000));
+            }
+        }
+    }
+}
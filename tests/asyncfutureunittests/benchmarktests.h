@@ -0,0 +1,52 @@
+#ifndef BENCHMARKTESTS_H
+#define BENCHMARKTESTS_H
+
+#include <QObject>
+
+/// Performance benchmarks. Run with -functions to list them.
+
+class BenchmarkTests : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BenchmarkTests(QObject *parent = nullptr);
+
+signals:
+
+private slots:
+
+    void benchmark_cache_hit_chain_data();
+    void benchmark_cache_hit_chain();
+
+    void benchmark_deferred_contention_data();
+    void benchmark_deferred_contention();
+
+    void benchmark_deferred_shared_lifecycle_data();
+    void benchmark_deferred_shared_lifecycle();
+
+    void benchmark_worker_chain_latency_main_blocked_data();
+    void benchmark_worker_chain_latency_main_blocked();
+
+    void benchmark_progress_coalescing_data();
+    void benchmark_progress_coalescing();
+
+    void benchmark_complete_by_future_data();
+    void benchmark_complete_by_future();
+
+    void benchmark_combine_progress();
+
+    void benchmark_combine_batch_data();
+    void benchmark_combine_batch();
+
+    void benchmark_combine_shard_data();
+    void benchmark_combine_shard();
+
+    void benchmark_combine_cancel_latency_data();
+    void benchmark_combine_cancel_latency();
+
+    void benchmark_observe_signal_data();
+    void benchmark_observe_signal();
+
+};
+
+#endif // BENCHMARKTESTS_H
@@ -8,6 +8,7 @@
 #include "bugtests.h"
 #include "samplecode.h"
 #include "cookbook.h"
+#include "benchmarktests.h"
 
 static void waitForFinished(QThreadPool *pool)
 {
@@ -25,6 +26,10 @@ int main(int argc, char *argv[])
 
     QCoreApplication app(argc, argv);
 
+    // The benchmarks are heavy. They run only if requested by --benchmark or ASYNCFUTURE_BENCHMARK=1
+    QStringList arguments = app.arguments();
+    bool benchmark = arguments.removeAll("--benchmark") > 0 || qEnvironmentVariableIntValue("ASYNCFUTURE_BENCHMARK") > 0;
+
     TestRunner runner;
     runner.add<Spec>();
     runner.add<BugTests>();
@@ -32,7 +37,11 @@ int main(int argc, char *argv[])
     runner.add<SampleCode>();
     runner.add<Cookbook>();
 
-    bool error = runner.exec(app.arguments());
+    if (benchmark) {
+        runner.add<BenchmarkTests>();
+    }
+
+    bool error = runner.exec(arguments);
 
     if (!error) {
         qDebug() << "All test cases passed!";
@@ -2,9 +2,11 @@
 #include <QTest>
 #include <QFuture>
 #include <QFutureWatcher>
+#include <QTimer>
 #include <Automator>
 #include <QFutureWatcher>
 #include "trackingdata.h"
+#include "allocationcounter.h"
 #include "testfunctions.h"
 #include "asyncfuture.h"
 #include "spec.h"
@@ -281,6 +283,54 @@ void Spec::test_private_DeferredFuture()
 
 }
 
+void Spec::test_private_ObjectPool()
+{
+    // Released in the same thread
+    void* ptr = Private::ObjectPool::allocate(500);
+    Private::ObjectPool::release(ptr);
+    QVERIFY(Private::ObjectPool::allocate(500) == ptr);
+
+    // Released by another thread, it goes back to the owner thread
+    auto before = Private::ObjectPool::statistics();
+    await(QtConcurrent::run([=]() {
+        Private::ObjectPool::release(ptr);
+    }));
+    auto after = Private::ObjectPool::statistics();
+    QCOMPARE(after.remoteReleases, before.remoteReleases + 1);
+    QVERIFY(Private::ObjectPool::allocate(500) == ptr);
+    Private::ObjectPool::release(ptr);
+
+    // A large object is not pooled
+    before = Private::ObjectPool::statistics();
+    ptr = Private::ObjectPool::allocate(4096);
+    Private::ObjectPool::release(ptr);
+    after = Private::ObjectPool::statistics();
+    QCOMPARE(after.heapAllocations, before.heapAllocations + 1);
+    QCOMPARE(after.heapReleases, before.heapReleases + 1);
+
+    // A steady-state chain reuses the objects of the previous one
+    auto chain = [&]() {
+        auto future = observe(completed<int>(1)).subscribe([](int value) {
+            return value + 1;
+        }).subscribe([](int value) {
+            return value * 2;
+        }).future();
+        await(future);
+        QCOMPARE(future.result(), 4);
+        QCoreApplication::processEvents();
+        QCoreApplication::sendPostedEvents(0, QEvent::DeferredDelete);
+    };
+
+    chain();
+
+    before = Private::ObjectPool::statistics();
+    for (int i = 0 ; i < 10; i++) {
+        chain();
+    }
+    after = Private::ObjectPool::statistics();
+    QCOMPARE(after.heapAllocations, before.heapAllocations);
+    QVERIFY(after.pooledAllocations > before.pooledAllocations);
+}
 
 void Spec::test_private_run()
 {
@@ -598,6 +648,144 @@ void Spec::test_Observable_context_return_future()
 
 }
 
+void Spec::test_Observable_then_executor()
+{
+    QThread* mainThread = QCoreApplication::instance()->thread();
+
+    {
+        // Thread pool
+        QThread* executedThread = nullptr;
+        auto future = observe(completed<int>(10)).then(Executor::threadPool(), [&](int value) {
+            executedThread = QThread::currentThread();
+            return value + 1;
+        }).future();
+
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.result(), 11);
+        QVERIFY(executedThread != mainThread);
+    }
+
+    {
+        // A specific thread
+        QThread thread;
+        thread.start();
+
+        QThread* executedThread = nullptr;
+        auto future = observe(completed<int>(10)).then(Executor::thread(&thread), [&](int value) {
+            executedThread = QThread::currentThread();
+            return value + 1;
+        }).future();
+
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.result(), 11);
+        QVERIFY(executedThread == &thread);
+
+        thread.quit();
+        thread.wait();
+    }
+
+    {
+        // Inline
+        auto defer = deferred<int>();
+        QThread* executedThread = nullptr;
+
+        auto future = defer.then(Executor::inlined(), [&](int value) {
+            executedThread = QThread::currentThread();
+            return value + 1;
+        }).future();
+
+        await(QtConcurrent::run([=]() {
+            auto d = defer;
+            d.complete(10);
+        }));
+
+        QVERIFY(future.isFinished());
+        QCOMPARE(future.result(), 11);
+        QVERIFY(executedThread != mainThread);
+    }
+
+    {
+        // Inline on a finished deferred. The callback observes another future while it is settled.
+        auto defer = deferred<int>();
+        defer.complete(1);
+
+        auto future = defer.then(Executor::inlined(), [](int value) {
+            return QtConcurrent::run([=]() {
+                return value + 1;
+            });
+        }).future();
+
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.result(), 2);
+    }
+
+    {
+        // User-defined queue
+        QList<Executor::Task> queue;
+        Executor executor([&](Executor::Task task) {
+            queue << task;
+        });
+
+        auto future = observe(completed<int>(10)).then(executor, [](int value) {
+            return value + 1;
+        }).then(executor, [](int value) {
+            return value * 2;
+        }).future();
+
+        QVERIFY(waitUntil([&]() {
+            return queue.size() > 0;
+        }, 1000));
+
+        while (queue.size() > 0) {
+            queue.takeFirst()();
+        }
+        QCOMPARE(future.isFinished(), true);
+        QCOMPARE(future.result(), 22);
+    }
+
+    {
+        // Executor::mainThread() is the same as subscribe()
+        QThread* executedThread = nullptr;
+        auto future = observe(QtConcurrent::run([]() {
+            return 10;
+        })).then(Executor::mainThread(), [&](int value) {
+            executedThread = QThread::currentThread();
+            return value + 1;
+        }).future();
+
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.result(), 11);
+        QVERIFY(executedThread == mainThread);
+    }
+}
+
+void Spec::test_Observable_observer_thread_finished()
+{
+    // The future is observed by a thread with an event loop, and the thread is finished before the future is.
+    // The main thread takes over, so the chain is still settled.
+    QThread thread;
+    thread.start();
+
+    QFuture<void> worker = QtConcurrent::run([]() {
+        Automator::wait(200);
+    });
+
+    QFuture<void> combined;
+
+    auto setup = observe(completed<int>(0)).then(Executor::thread(&thread), [&](int) {
+        combined = (combine() << worker).future();
+    }).future();
+
+    QVERIFY(waitUntil(setup, 1000));
+
+    thread.quit();
+    thread.wait();
+
+    QCOMPARE(combined.isFinished(), false);
+    QVERIFY(waitUntil(combined, 1000));
+    QCOMPARE(combined.isCanceled(), false);
+}
+
 void Spec::test_Observable_signal()
 {
     auto proxy = new SignalProxy(this);
@@ -715,6 +903,258 @@ void Spec::test_Observable_signal_by_signature()
         delete proxy;
     }
 
+    {
+        // Signatures without the code, and not normalized. They are resolved once and cached.
+        auto *proxy = new SignalProxy(this);
+
+        for (int i = 0 ; i < 3 ; i++) {
+            QFuture<QVariant> f1 = observe(proxy, "proxy1(int)").future();
+            QFuture<QVariant> f2 = observe(proxy, "proxy1( int )").future();
+            QCOMPARE(f1.isCanceled(), false);
+            QCOMPARE(f2.isCanceled(), false);
+
+            emit proxy->proxy1(i);
+
+            QVERIFY(waitUntil(f1, 1000));
+            QVERIFY(waitUntil(f2, 1000));
+            QCOMPARE(f1.result().toInt(), i);
+            QCOMPARE(f2.result().toInt(), i);
+        }
+
+        delete proxy;
+    }
+
+}
+
+void Spec::test_Observable_signal_direct()
+{
+    auto proxy = new SignalProxy(this);
+
+    // Completed inside the emission
+    QFuture<int> f1 = observe(proxy, &SignalProxy::proxy1, Qt::DirectConnection).future();
+    QFuture<int> f2 = observe(proxy, &SignalProxy::proxy1, Qt::AutoConnection).future();
+    QFuture<QVariant> f3 = observe(proxy, SIGNAL(proxy1(int)), Qt::DirectConnection).future();
+    QFuture<void> f4 = observe(proxy, &SignalProxy::proxy0, Qt::DirectConnection).future();
+
+    emit proxy->proxy1(5);
+    emit proxy->proxy0();
+
+    QCOMPARE(f1.isFinished(), true);
+    QCOMPARE(f1.result(), 5);
+    QCOMPARE(f2.isFinished(), true);
+    QCOMPARE(f2.result(), 5);
+    QCOMPARE(f3.isFinished(), true);
+    QCOMPARE(f3.result().toInt(), 5);
+    QCOMPARE(f4.isFinished(), true);
+
+    // Only the first emission is taken
+    emit proxy->proxy1(6);
+    QCOMPARE(f1.result(), 5);
+
+    delete proxy;
+}
+
+void Spec::test_Observable_signal_arguments()
+{
+    auto proxy = new SignalProxy(this);
+
+    QFuture<std::tuple<int, QString>> f1 = observe(proxy, &SignalProxy::proxy2).future();
+    QFuture<std::tuple<int, QString>> f2 = observe(proxy, &SignalProxy::proxy2, Qt::DirectConnection).future();
+    QFuture<std::tuple<int, QString>> f3 = stream(proxy, &SignalProxy::proxy2);
+
+    emit proxy->proxy2(1, "first");
+
+    QCOMPARE(f2.isFinished(), true);
+    QCOMPARE(std::get<0>(f2.result()), 1);
+    QCOMPARE(std::get<1>(f2.result()), QString("first"));
+
+    emit proxy->proxy2(2, "second");
+
+    QVERIFY(waitUntil(f1, 1000));
+    QCOMPARE(std::get<0>(f1.result()), 1);
+    QCOMPARE(std::get<1>(f1.result()), QString("first"));
+
+    delete proxy;
+
+    QVERIFY(waitUntil(f3, 1000));
+    QCOMPARE(f3.resultCount(), 2);
+    QCOMPARE(std::get<1>(f3.resultAt(1)), QString("second"));
+}
+
+void Spec::test_Observable_signal_shared()
+{
+    {
+        // Observers of the same signal share one connection
+        auto proxy = new SignalProxy(this);
+
+        QList<QFuture<int>> futures;
+        for (int i = 0 ; i < 100 ; i++) {
+            futures << observe(proxy, &SignalProxy::proxy1).future();
+        }
+
+        QCOMPARE(proxy->receiverCount(SIGNAL(proxy1(int))), 1);
+
+        emit proxy->proxy1(7);
+
+        for (int i = 0 ; i < futures.size() ; i++) {
+            QVERIFY(waitUntil(futures[i], 1000));
+            QCOMPARE(futures[i].result(), 7);
+        }
+
+        QCOMPARE(proxy->receiverCount(SIGNAL(proxy1(int))), 0);
+
+        // A new observer after the emission waits for the next one
+        QFuture<int> next = observe(proxy, &SignalProxy::proxy1).future();
+        emit proxy->proxy1(8);
+        QVERIFY(waitUntil(next, 1000));
+        QCOMPARE(next.result(), 8);
+
+        delete proxy;
+    }
+
+    {
+        // The connection is dropped once all the observers are canceled
+        auto proxy = new SignalProxy(this);
+
+        QFuture<int> f1 = observe(proxy, &SignalProxy::proxy1).future();
+        QFuture<int> f2 = observe(proxy, &SignalProxy::proxy1).future();
+
+        f1.cancel();
+        Automator::wait(10);
+        QCOMPARE(proxy->receiverCount(SIGNAL(proxy1(int))), 1);
+
+        f2.cancel();
+        QVERIFY(waitUntil([=]() {
+            return proxy->receiverCount(SIGNAL(proxy1(int))) == 0;
+        }, 1000));
+
+        delete proxy;
+    }
+
+    {
+        // All the observers are canceled once the sender is destroyed
+        auto proxy = new SignalProxy(this);
+
+        QFuture<int> f1 = observe(proxy, &SignalProxy::proxy1).future();
+        QFuture<int> f2 = observe(proxy, &SignalProxy::proxy1).future();
+
+        delete proxy;
+
+        QVERIFY(waitUntil(f1, 1000));
+        QVERIFY(waitUntil(f2, 1000));
+        QCOMPARE(f1.isCanceled(), true);
+        QCOMPARE(f2.isCanceled(), true);
+    }
+}
+
+void Spec::test_stream()
+{
+    {
+        // Every emission is a result. It is completed once the sender is destroyed.
+        auto proxy = new SignalProxy(this);
+
+        QFuture<int> future = stream(proxy, &SignalProxy::proxy1);
+
+        emit proxy->proxy1(1);
+        emit proxy->proxy1(2);
+
+        QVERIFY(waitUntil([=]() {
+            return future.resultCount() == 2;
+        }, 1000));
+
+        emit proxy->proxy1(3);
+        delete proxy;
+
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), false);
+        QCOMPARE(future.results(), QList<int>() << 1 << 2 << 3);
+    }
+
+    {
+        // Overflow policy
+        auto proxy = new SignalProxy(this);
+
+        QFuture<int> oldest = stream(proxy, &SignalProxy::proxy1, 2, DropOldest);
+        QFuture<int> newest = stream(proxy, &SignalProxy::proxy1, 2, DropNewest);
+        QFuture<int> flush = stream(proxy, &SignalProxy::proxy1, 2, FlushBuffer);
+
+        emit proxy->proxy1(1);
+        emit proxy->proxy1(2);
+        emit proxy->proxy1(3);
+        delete proxy;
+
+        QVERIFY(waitUntil(oldest, 1000));
+        QVERIFY(waitUntil(newest, 1000));
+        QVERIFY(waitUntil(flush, 1000));
+
+        QCOMPARE(oldest.results(), QList<int>() << 2 << 3);
+        QCOMPARE(newest.results(), QList<int>() << 1 << 2);
+        QCOMPARE(flush.results(), QList<int>() << 1 << 2 << 3);
+    }
+
+    {
+        // The batch size bounds each event loop pass, not the results kept by the future
+        auto proxy = new SignalProxy(this);
+
+        QFuture<int> future = stream(proxy, &SignalProxy::proxy1, 2, DropNewest);
+
+        for (int i = 0 ; i < 5 ; i++) {
+            emit proxy->proxy1(i);
+        }
+
+        QVERIFY(waitUntil([=]() {
+            return future.resultCount() == 2;
+        }, 1000));
+
+        for (int i = 5 ; i < 10 ; i++) {
+            emit proxy->proxy1(i);
+        }
+
+        QVERIFY(waitUntil([=]() {
+            return future.resultCount() == 4;
+        }, 1000));
+
+        delete proxy;
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.results(), QList<int>() << 0 << 1 << 5 << 6);
+    }
+
+    {
+        // Canceling it disconnects the signal
+        auto proxy = new SignalProxy(this);
+
+        QFuture<int> future = stream(proxy, &SignalProxy::proxy1);
+        future.cancel();
+        Automator::wait(10);
+
+        emit proxy->proxy1(1);
+        Automator::wait(10);
+
+        QCOMPARE(future.resultCount(), 0);
+        delete proxy;
+    }
+
+    {
+        // A direct connection is queued for the emissions from another thread
+        auto proxy = new SignalProxy(this);
+
+        QFuture<int> future = stream(proxy, &SignalProxy::proxy1, 0, FlushBuffer, Qt::DirectConnection);
+
+        QFuture<void> worker = QtConcurrent::run([=]() {
+            for (int i = 0 ; i < 100 ; i++) {
+                emit proxy->proxy1(i);
+            }
+        });
+        await(worker);
+
+        QVERIFY(waitUntil([=]() {
+            return future.resultCount() == 100;
+        }, 1000));
+
+        delete proxy;
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.results().last(), 99);
+    }
 }
 
 void Spec::test_Observable_signal_destroyed()
@@ -803,8 +1243,9 @@ void Spec::test_Observable_subscribe_in_thread()
             Automator::wait(50);
         };
 
+        // It is run by the background dispatcher, not by the main thread
         auto cleanup = [&]() -> void {
-            QVERIFY(QThread::currentThread() == QCoreApplication::instance()->thread());
+            QVERIFY(QThread::currentThread() != QCoreApplication::instance()->thread());
             Automator::wait(50);
         };
 
@@ -821,64 +1262,314 @@ void Spec::test_Observable_subscribe_in_thread()
     QVERIFY(waitUntil(future , 1000));
 }
 
-void Spec::test_Observable_subscribe_return_future()
+void Spec::test_Observable_subscribe_thread_finished()
 {
-    auto bWorker = [=]() -> bool {
-        Automator::wait(50);
-        return true;
-    };
+    // The callbacks of a thread running an event loop are still delivered after the thread is finished
+    QThread thread;
 
-    auto futureCleanupBool = [&](bool value) {
-        Q_UNUSED(value)
-        auto internalWorker = [=]() -> int {
-            Automator::wait(50);
+    QObject* context = new QObject();
+    context->moveToThread(&thread);
+    connect(&thread, &QThread::finished, context, &QObject::deleteLater);
 
-            return 10;
-        };
-        QFuture<int> future = QtConcurrent::run(internalWorker);
-        return future;
-    };
+    thread.start();
 
-    Observable<bool> observable1 = observe(QtConcurrent::run(bWorker));
-    Observable<int> observable2 = observable1.subscribe(futureCleanupBool);
+    auto defer = deferred<int>();
+    QAtomicInt subscribed;
+    int value = 0;
+    QFuture<void> future;
 
-    waitUntil(observable2.future(), 1000);
-    QCOMPARE(observable2.future().result(), 10);
+    QTimer::singleShot(0, context, [&]() {
+        future = observe(defer.future()).subscribe([&](int v) {
+            value = v;
+        }).future();
+        subscribed.storeRelease(1);
+    });
 
-    observable2 = observe(QtConcurrent::run(bWorker)).subscribe(futureCleanupBool,[]() {});
-    QCOMPARE(observable2.future().isFinished(), false);
-    waitUntil(observable2.future(), 1000);
-    QCOMPARE(observable2.future().result(), 10);
-}
+    QVERIFY(waitUntil([&]() {
+        return subscribed.loadAcquire() == 1;
+    }, 1000));
 
-void Spec::test_Observable_subscribe_return_canceledFuture()
-{
-    auto start = Deferred<void>();
-    auto f1 = start.future();
-    QList<int> sequence;
-    QList<int> expectedSequence;
-    expectedSequence << 2;
+    thread.quit();
+    thread.wait();
 
-    auto defer = Deferred<void>();
-    defer.cancel();
-    auto canceledFuture = defer.future();
+    defer.complete(10);
 
-    auto f2 = observe(f1).subscribe([&]() {
-        sequence << 2;
-        return canceledFuture;
-    }).future();
+    QVERIFY(waitUntil(future, 1000));
+    QCOMPARE(future.isCanceled(), false);
+    QCOMPARE(value, 10);
+}
 
-    auto f3 = observe(f2).subscribe([&]() {
-        sequence << 3;
-    }).future();
+void Spec::test_Observable_subscribe_multiple_observers()
+{
+    {
+        // Deferred: observers are called in order
+        auto defer = deferred<int>();
+        QList<int> calls;
 
-    start.complete();
+        for (int i = 0 ; i < 100 ; i++) {
+            defer.subscribe([&calls, i](int value) {
+                QCOMPARE(value, 10);
+                calls << i;
+            });
+        }
 
-    waitUntil(f3, 1000);
+        defer.complete(10);
+        QCOMPARE(calls.size(), 0);
 
-    QCOMPARE(sequence, expectedSequence);
+        QVERIFY(waitUntil([&]() {
+            return calls.size() == 100;
+        }, 1000));
 
-}
+        for (int i = 0 ; i < 100 ; i++) {
+            QCOMPARE(calls[i], i);
+        }
+    }
+
+    {
+        // QtConcurrent::run
+        auto future = QtConcurrent::run([]() {
+            Automator::wait(50);
+            return 10;
+        });
+
+        int count = 0;
+        for (int i = 0 ; i < 100 ; i++) {
+            observe(future).subscribe([&count](int value) {
+                QCOMPARE(value, 10);
+                count++;
+            });
+        }
+
+        QVERIFY(waitUntil([&]() {
+            return count == 100;
+        }, 1000));
+    }
+
+    {
+        // QFuture::cancel() on the future of a Deferred
+        auto defer = deferred<int>();
+        int canceled = 0;
+
+        for (int i = 0 ; i < 10 ; i++) {
+            defer.subscribe([](){}, [&canceled]() {
+                canceled++;
+            });
+        }
+
+        defer.future().cancel();
+
+        QVERIFY(waitUntil([&]() {
+            return canceled == 10;
+        }, 1000));
+    }
+
+    {
+        // Observe after finished
+        auto defer = deferred<int>();
+        defer.complete(5);
+
+        Callable<int> c;
+        defer.subscribe(c.func);
+        QCOMPARE(c.called, false);
+
+        QVERIFY(waitUntil([&]() {
+            return c.called;
+        }, 1000));
+        QCOMPARE(c.value, 5);
+    }
+}
+
+void Spec::test_Observable_inlineIfReady()
+{
+    {
+        // Finished future
+        auto c1 = Callable<int>();
+        auto result = observe(completed<int>(5)).inlineIfReady().subscribe([&](int value) {
+            c1.func(value);
+            return value * 2;
+        }).future();
+
+        QCOMPARE(c1.called, true);
+        QCOMPARE(c1.value, 5);
+        QCOMPARE(result.isFinished(), true);
+        QCOMPARE(result.result(), 10);
+    }
+
+    {
+        // The mode is inherited by the returned Observable
+        int value = 0;
+        observe(completed<int>(5)).inlineIfReady().subscribe([](int value) {
+            return value + 1;
+        }).subscribe([&](int v) {
+            value = v;
+        });
+
+        QCOMPARE(value, 6);
+    }
+
+    {
+        // Canceled future
+        auto defer = deferred<int>();
+        defer.cancel();
+
+        auto c1 = Callable<int>();
+        auto c2 = Callable<void>();
+        auto result = defer.inlineIfReady().subscribe(c1.func, c2.func).future();
+
+        QCOMPARE(c1.called, false);
+        QCOMPARE(c2.called, true);
+        QCOMPARE(result.isCanceled(), true);
+    }
+
+    {
+        // Not finished yet
+        auto defer = deferred<int>();
+        auto c1 = Callable<int>();
+        auto result = defer.inlineIfReady().subscribe(c1.func).future();
+
+        defer.complete(5);
+        QCOMPARE(c1.called, false);
+
+        QVERIFY(waitUntil(result, 1000));
+        QCOMPARE(c1.called, true);
+    }
+
+    {
+        // The context object lives in another thread
+        QThread thread;
+        QObject context;
+        context.moveToThread(&thread);
+        thread.start();
+
+        auto c1 = Callable<int>();
+        auto result = observe(completed<int>(5)).inlineIfReady().context(&context, c1.func).future();
+        QCOMPARE(result.isFinished(), false);
+
+        QVERIFY(waitUntil(result, 1000));
+        QCOMPARE(c1.called, true);
+
+        thread.quit();
+        thread.wait();
+    }
+
+    {
+        // Default mode
+        auto c1 = Callable<int>();
+        auto result = observe(completed<int>(5)).subscribe(c1.func).future();
+
+        QCOMPARE(c1.called, false);
+        QVERIFY(waitUntil(result, 1000));
+        QCOMPARE(c1.called, true);
+    }
+}
+
+void Spec::test_Observable_subscribe_allocation()
+{
+    const int count = 100;
+
+    auto defer = deferred<int>();
+    defer.subscribe([](int) {}); // Warm up
+
+    AllocationCounter counter;
+
+    // The cost of a DeferredFuture alone. It is the private data of QObject and QFutureInterface and the registry entry.
+    QVector<Private::DeferredPointer<Private::DeferredFuture<void>>> deferredFutures;
+    deferredFutures.reserve(count);
+
+    auto before = Private::ObjectPool::statistics();
+    counter.start();
+    for (int i = 0 ; i < count ; i++) {
+        deferredFutures << Private::DeferredFuture<void>::create();
+    }
+    counter.stop();
+    auto after = Private::ObjectPool::statistics();
+
+    QCOMPARE(after.heapAllocations + after.pooledAllocations - before.heapAllocations - before.pooledAllocations, count);
+    int deferredCost = (counter.count() - (after.heapAllocations - before.heapAllocations)) / count;
+
+    QVector<Observable<void>> observables;
+    observables.reserve(count);
+
+    before = Private::ObjectPool::statistics();
+    counter.start();
+    for (int i = 0 ; i < count ; i++) {
+        observables << defer.subscribe([](int) {});
+    }
+    counter.stop();
+    after = Private::ObjectPool::statistics();
+
+    // A DeferredFuture and one chain node per subscribe(), both taken from the object pool
+    QCOMPARE(after.heapAllocations + after.pooledAllocations - before.heapAllocations - before.pooledAllocations, count * 2);
+
+    // Nothing else is allocated: no watcher, no shared pointer and no connection
+    int subscribeCost = (counter.count() - (after.heapAllocations - before.heapAllocations)) / count;
+    QVERIFY2(subscribeCost == deferredCost,
+             QString("subscribe(): %1 allocations, DeferredFuture: %2 allocations").arg(subscribeCost).arg(deferredCost).toLocal8Bit());
+
+    defer.complete(1);
+    QVERIFY(waitUntil([&]() {
+        return observables.last().future().isFinished();
+    }, 1000));
+}
+
+void Spec::test_Observable_subscribe_return_future()
+{
+    auto bWorker = [=]() -> bool {
+        Automator::wait(50);
+        return true;
+    };
+
+    auto futureCleanupBool = [&](bool value) {
+        Q_UNUSED(value)
+        auto internalWorker = [=]() -> int {
+            Automator::wait(50);
+
+            return 10;
+        };
+        QFuture<int> future = QtConcurrent::run(internalWorker);
+        return future;
+    };
+
+    Observable<bool> observable1 = observe(QtConcurrent::run(bWorker));
+    Observable<int> observable2 = observable1.subscribe(futureCleanupBool);
+
+    waitUntil(observable2.future(), 1000);
+    QCOMPARE(observable2.future().result(), 10);
+
+    observable2 = observe(QtConcurrent::run(bWorker)).subscribe(futureCleanupBool,[]() {});
+    QCOMPARE(observable2.future().isFinished(), false);
+    waitUntil(observable2.future(), 1000);
+    QCOMPARE(observable2.future().result(), 10);
+}
+
+void Spec::test_Observable_subscribe_return_canceledFuture()
+{
+    auto start = Deferred<void>();
+    auto f1 = start.future();
+    QList<int> sequence;
+    QList<int> expectedSequence;
+    expectedSequence << 2;
+
+    auto defer = Deferred<void>();
+    defer.cancel();
+    auto canceledFuture = defer.future();
+
+    auto f2 = observe(f1).subscribe([&]() {
+        sequence << 2;
+        return canceledFuture;
+    }).future();
+
+    auto f3 = observe(f2).subscribe([&]() {
+        sequence << 3;
+    }).future();
+
+    start.complete();
+
+    waitUntil(f3, 1000);
+
+    QCOMPARE(sequence, expectedSequence);
+
+}
 
 void Spec::test_Observable_subscribe_return_mappedFuture()
 {
@@ -1657,6 +2348,146 @@ void Spec::test_Deferred_setProgress()
     QCOMPARE(defer.future().progressValue(), 3);
 }
 
+void Spec::test_Deferred_coalesceProgress()
+{
+    {
+        auto defer = deferred<int>();
+        defer.setProgressRange(0, 100);
+        defer.coalesceProgress(ProgressCoalescing::delta(10));
+
+        defer.setProgressValue(5);
+        QCOMPARE(defer.future().progressValue(), 0);
+
+        defer.setProgressValue(10);
+        QCOMPARE(defer.future().progressValue(), 10);
+
+        defer.setProgressValue(15);
+        QCOMPARE(defer.future().progressValue(), 10);
+
+        // The maximum is always passed on
+        defer.setProgressValue(100);
+        QCOMPARE(defer.future().progressValue(), 100);
+    }
+
+    {
+        auto defer = deferred<int>();
+        defer.setProgressRange(0, 100);
+        defer.coalesceProgress(ProgressCoalescing::eventLoopPass());
+
+        for (int i = 1 ; i < 50; i++) {
+            defer.setProgressValue(i);
+        }
+        QCOMPARE(defer.future().progressValue(), 0);
+
+        // Only the latest value is passed on
+        QCoreApplication::processEvents();
+        QCOMPARE(defer.future().progressValue(), 49);
+    }
+
+    {
+        auto defer = deferred<int>();
+        defer.setProgressRange(0, 100);
+        defer.coalesceProgress(ProgressCoalescing::interval(60000));
+
+        defer.setProgressValue(1);
+        defer.setProgressValue(2);
+        QCOMPARE(defer.future().progressValue(), 1);
+    }
+
+    {
+        // The last value held back is passed on once the interval is over
+        auto defer = deferred<int>();
+        defer.setProgressRange(0, 100);
+        defer.coalesceProgress(ProgressCoalescing::interval(50));
+
+        defer.setProgressValue(1);
+        defer.setProgressValue(2);
+        defer.setProgressValue(3);
+        QCOMPARE(defer.future().progressValue(), 1);
+
+        QVERIFY(waitUntil([=]() {
+            return defer.future().progressValue() == 3;
+        }, 1000));
+    }
+
+    {
+        // The last value held back is passed on when the future is finished
+        auto defer = deferred<int>();
+        defer.setProgressRange(0, 100);
+        defer.coalesceProgress(ProgressCoalescing::interval(60000));
+
+        defer.setProgressValue(1);
+        defer.setProgressValue(2);
+        defer.complete(1);
+        QCOMPARE(defer.future().progressValue(), 2);
+    }
+
+    {
+        // Delta: the last value held back is passed on when the future is finished
+        auto defer = deferred<int>();
+        defer.setProgressRange(0, 100);
+        defer.coalesceProgress(ProgressCoalescing::delta(10));
+
+        defer.setProgressValue(10);
+        defer.setProgressValue(15);
+        QCOMPARE(defer.future().progressValue(), 10);
+
+        defer.complete(1);
+        QCOMPARE(defer.future().progressValue(), 15);
+    }
+
+    {
+        // EventLoopPass: the last value is passed on if the future is finished before the flush runs
+        auto defer = deferred<int>();
+        defer.setProgressRange(0, 100);
+        defer.coalesceProgress(ProgressCoalescing::eventLoopPass());
+
+        for (int i = 1 ; i < 50; i++) {
+            defer.setProgressValue(i);
+        }
+        defer.complete(1);
+        QCOMPARE(defer.future().progressValue(), 49);
+
+        // The posted flush has nothing left to pass on
+        QCoreApplication::processEvents();
+        QCOMPARE(defer.future().progressValue(), 49);
+    }
+}
+
+void Spec::test_Deferred_complete_race()
+{
+    // Only one of the completions made by several threads at the same time takes effect
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+
+    for (int round = 0 ; round < 100 ; round++) {
+        auto defer = deferred<int>();
+
+        QList<QFuture<void>> workers;
+        for (int i = 0 ; i < 4 ; i++) {
+            workers << QtConcurrent::run(&pool, [=]() mutable {
+                if (i == 3) {
+                    defer.cancel();
+                } else {
+                    defer.complete(i);
+                }
+            });
+        }
+
+        for (int i = 0 ; i < workers.size() ; i++) {
+            await(workers[i]);
+        }
+
+        QFuture<int> future = defer.future();
+        QCOMPARE(future.isFinished(), true);
+        if (future.isCanceled()) {
+            QCOMPARE(future.resultCount(), 0);
+        } else {
+            QCOMPARE(future.resultCount(), 1);
+        }
+    }
+}
+
 void Spec::test_Deferred_reportStarted()
 {
     {
@@ -1931,29 +2762,674 @@ void Spec::test_Combinator_progressValue()
 
     }
 
+    {
+        // Add a list of futures at once
+        auto d1 = deferred<int>();
+        auto d2 = deferred<int>();
+        d2.setProgressRange(0, 4);
+        d2.setProgressValue(2);
+
+        auto combinator = combine();
+        auto future = combinator.future();
+
+        combinator << (QList<QFuture<int>>() << d1.future() << d2.future() << completed<int>(3));
+
+        QCOMPARE(future.progressValue(), 3);
+        QCOMPARE(future.progressMaximum(), 6);
+
+        d1.complete(1);
+        d2.complete(2);
+        await(future);
+
+        QCOMPARE(future.isCanceled(), false);
+        QCOMPARE(future.progressValue(), 6);
+        QCOMPARE(future.progressMaximum(), 6);
+    }
+
 }
 
-void Spec::test_alive()
+void Spec::test_Combinator_progress_weight()
 {
-
     {
-        auto d1 = deferred<TrackingData>();
-        auto d2 = deferred<TrackingData>();
+        // Bytes and items take equal shares
+        auto bytes = deferred<int>();
+        auto items = deferred<int>();
+        bytes.setProgressRange(0, 1000000);
+        items.setProgressRange(0, 10);
 
-        d2.complete(d1.future());
+        auto combinator = combine();
+        combinator.combine(bytes.future(), 100).combine(items.future(), 100);
+        auto future = combinator.future();
 
-        QCOMPARE(TrackingData::aliveCount(), 0);
+        QCOMPARE(future.progressMaximum(), 200);
 
-        {
-            TrackingData dummy;
-            d1.complete(dummy);
-            QCOMPARE(TrackingData::aliveCount(), 1);
-        }
+        bytes.setProgressValue(500000);
+        items.setProgressValue(5);
 
-        QCOMPARE(TrackingData::aliveCount(), 1);
+        QVERIFY(waitUntil([=]() {
+            return future.progressValue() == 100;
+        }, 1000));
 
-        await(d2.future());
-        Automator::wait(10);
+        bytes.complete(1);
+        items.complete(2);
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.progressValue(), 200);
+    }
+
+    {
+        // The sum exceeds the int range
+        const int max = std::numeric_limits<int>::max();
+        auto d1 = deferred<int>();
+        auto d2 = deferred<int>();
+        auto d3 = deferred<int>();
+        d1.setProgressRange(0, max);
+        d2.setProgressRange(0, max);
+        d3.setProgressRange(0, max);
+
+        auto combinator = combine() << d1.future() << d2.future() << d3.future();
+        auto future = combinator.future();
+
+        QCOMPARE(future.progressMaximum(), max);
+        QCOMPARE(future.progressValue(), 0);
+
+        d1.complete(1);
+        QVERIFY(waitUntil([=]() {
+            return future.progressValue() > 0;
+        }, 1000));
+        QVERIFY(qAbs(future.progressValue() - max / 3) <= 1);
+
+        d2.complete(2);
+        d3.complete(3);
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.progressValue(), max);
+    }
+}
+
+void Spec::test_Combinator_shard()
+{
+    {
+        // Completed once all the futures are completed
+        QList<Deferred<int>> defers;
+        QList<QFuture<int>> futures;
+        for (int i = 0 ; i < 1000 ; i++) {
+            auto defer = deferred<int>();
+            defers << defer;
+            futures << defer.future();
+        }
+
+        auto combinator = combine();
+        combinator.shard(64) << futures;
+        auto future = combinator.future();
+
+        QCOMPARE(future.progressMaximum(), 1000);
+
+        for (int i = 0 ; i < defers.size() ; i++) {
+            defers[i].complete(i);
+        }
+
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), false);
+        QCOMPARE(future.progressValue(), 1000);
+    }
+
+    {
+        // FailFast is kept
+        QList<Deferred<int>> defers;
+        QList<QFuture<int>> futures;
+        for (int i = 0 ; i < 100 ; i++) {
+            auto defer = deferred<int>();
+            defers << defer;
+            futures << defer.future();
+        }
+
+        auto combinator = combine(FailFast);
+        combinator.shard(10) << futures;
+        auto future = combinator.future();
+
+        defers[55].cancel();
+
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), true);
+
+        // The cancellation is passed down through the sub-combiners
+        QVERIFY(waitUntil(defers[0].future(), 1000));
+        QCOMPARE(defers[0].future().isCanceled(), true);
+    }
+
+    {
+        // AllSettled is kept
+        QList<Deferred<int>> defers;
+        QList<QFuture<int>> futures;
+        for (int i = 0 ; i < 100 ; i++) {
+            auto defer = deferred<int>();
+            defers << defer;
+            futures << defer.future();
+        }
+
+        auto combinator = combine(AllSettled);
+        combinator.shard(10) << futures;
+        auto future = combinator.future();
+
+        defers[0].cancel();
+        Automator::wait(10);
+        QCOMPARE(future.isFinished(), false);
+
+        for (int i = 1 ; i < defers.size() ; i++) {
+            defers[i].complete(i);
+        }
+
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), true);
+    }
+}
+
+void Spec::test_Combinator_parallelCancel()
+{
+    QList<Deferred<int>> defers;
+    QList<QFuture<int>> futures;
+    for (int i = 0 ; i < 100 ; i++) {
+        auto defer = deferred<int>();
+        defers << defer;
+        futures << defer.future();
+    }
+
+    auto combinator = combine();
+    combinator.parallelCancel(10) << futures;
+    defers[0].complete(0);
+
+    combinator.future().cancel();
+
+    QVERIFY(waitUntil([=]() {
+        for (int i = 1 ; i < defers.size() ; i++) {
+            if (!defers[i].future().isCanceled()) {
+                return false;
+            }
+        }
+        return true;
+    }, 1000));
+
+    QCOMPARE(defers[0].future().isCanceled(), false);
+}
+
+void Spec::test_Combinator_factories()
+{
+    {
+        // At most 3 futures in flight
+        QSharedPointer<QAtomicInt> running(new QAtomicInt(0));
+        QSharedPointer<QAtomicInt> peak(new QAtomicInt(0));
+        QSharedPointer<QAtomicInt> called(new QAtomicInt(0));
+
+        QList<std::function<QFuture<void>()>> factories;
+        for (int i = 0 ; i < 20 ; i++) {
+            factories << [=]() {
+                called->ref();
+                return QtConcurrent::run([=]() {
+                    int value = running->fetchAndAddOrdered(1) + 1;
+                    int current = peak->loadAcquire();
+                    while (value > current && !peak->testAndSetOrdered(current, value)) {
+                        current = peak->loadAcquire();
+                    }
+                    Automator::wait(5);
+                    running->fetchAndAddOrdered(-1);
+                });
+            };
+        }
+
+        auto combinator = combine(factories, 3);
+        auto future = combinator.future();
+        QCOMPARE(future.progressMaximum(), 20);
+
+        QVERIFY(waitUntil(future, 5000));
+        QCOMPARE(future.isCanceled(), false);
+        QCOMPARE(called->loadAcquire(), 20);
+        QVERIFY(peak->loadAcquire() <= 3);
+        QCOMPARE(future.progressValue(), 20);
+    }
+
+    {
+        // FailFast stops calling the factories
+        QSharedPointer<QAtomicInt> called(new QAtomicInt(0));
+
+        QList<std::function<QFuture<int>()>> factories;
+        for (int i = 0 ; i < 10 ; i++) {
+            factories << [=]() {
+                called->ref();
+                auto defer = deferred<int>();
+                if (i == 1) {
+                    defer.cancel();
+                } else {
+                    defer.complete(i);
+                }
+                return defer.future();
+            };
+        }
+
+        auto combinator = combine(factories, 1, FailFast);
+        auto future = combinator.future();
+
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), true);
+        Automator::wait(10);
+        QCOMPARE(called->loadAcquire(), 2);
+    }
+
+    {
+        // AllSettled calls all of them
+        QSharedPointer<QAtomicInt> called(new QAtomicInt(0));
+
+        QList<std::function<QFuture<int>()>> factories;
+        for (int i = 0 ; i < 10 ; i++) {
+            factories << [=]() {
+                called->ref();
+                auto defer = deferred<int>();
+                if (i == 1) {
+                    defer.cancel();
+                } else {
+                    defer.complete(i);
+                }
+                return defer.future();
+            };
+        }
+
+        auto combinator = combine(factories, 2, AllSettled);
+        auto future = combinator.future();
+
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), true);
+        QCOMPARE(called->loadAcquire(), 10);
+    }
+}
+
+void Spec::test_all()
+{
+    {
+        // Results are in input order
+        QList<QFuture<int>> futures;
+        futures << QtConcurrent::run([]() {
+            Automator::wait(60);
+            return 1;
+        });
+        futures << QtConcurrent::run([]() {
+            Automator::wait(10);
+            return 2;
+        });
+        futures << completed<int>(QList<int>() << 3 << 4);
+
+        QFuture<int> future = all(futures);
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), false);
+        QCOMPARE(future.results(), QList<int>() << 1 << 2 << 3 << 4);
+    }
+
+    {
+        // Canceled if any future is canceled
+        auto d1 = deferred<int>();
+        auto d2 = deferred<int>();
+
+        QFuture<int> future = all(QList<QFuture<int>>() << d1.future() << d2.future());
+        d1.cancel();
+
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), true);
+    }
+
+    {
+        // Cancel the unfinished futures
+        auto d1 = deferred<int>();
+        auto d2 = deferred<int>();
+
+        QFuture<int> future = all(QList<QFuture<int>>() << d1.future() << d2.future());
+        d1.complete(1);
+        future.cancel();
+
+        QVERIFY(waitUntil(d2.future(), 1000));
+        QCOMPARE(d2.future().isCanceled(), true);
+    }
+
+    {
+        QFuture<int> future = all(QList<QFuture<int>>());
+        QCOMPARE(future.isFinished(), true);
+        QCOMPARE(future.resultCount(), 0);
+    }
+
+    {
+        // Futures without results
+        QFuture<void> future = all(QList<QFuture<void>>() << completed() << QtConcurrent::run([]() {}));
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), false);
+    }
+}
+
+void Spec::test_all_tuple()
+{
+    auto d1 = deferred<int>();
+    auto d2 = deferred<QString>();
+
+    QFuture<std::tuple<int, QString, bool>> future = all(d1.future(), d2.future(), completed<bool>(true));
+
+    d2.complete("second");
+    QCOMPARE(future.isFinished(), false);
+
+    d1.complete(1);
+
+    QVERIFY(waitUntil(future, 1000));
+    auto result = future.result();
+    QCOMPARE(std::get<0>(result), 1);
+    QCOMPARE(std::get<1>(result), QString("second"));
+    QCOMPARE(std::get<2>(result), true);
+
+    {
+        // A future finished without a result
+        auto d3 = deferred<int>();
+        QFuture<std::tuple<int, bool>> empty = all(d3.future(), completed<bool>(true));
+
+        QFutureInterface<int> fi(QFutureInterfaceBase::Started);
+        d3.complete(fi.future());
+        fi.reportFinished();
+
+        QVERIFY(waitUntil(empty, 1000));
+        QCOMPARE(empty.isCanceled(), true);
+    }
+}
+
+void Spec::test_race()
+{
+    {
+        // The first completed future wins. The rest are canceled.
+        auto d1 = deferred<int>();
+        auto d2 = deferred<int>();
+        auto d3 = deferred<int>();
+
+        QFuture<int> future = race(QList<QFuture<int>>() << d1.future() << d2.future() << d3.future());
+
+        d2.complete(2);
+
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), false);
+        QCOMPARE(future.results(), QList<int>() << 2);
+
+        QVERIFY(waitUntil(d1.future(), 1000));
+        QCOMPARE(d1.future().isCanceled(), true);
+        QCOMPARE(d3.future().isCanceled(), true);
+    }
+
+    {
+        // A canceled future does not win
+        auto d1 = deferred<int>();
+        auto d2 = deferred<int>();
+
+        QFuture<int> future = race(QList<QFuture<int>>() << d1.future() << d2.future());
+        d1.cancel();
+        Automator::wait(10);
+        QCOMPARE(future.isFinished(), false);
+
+        d2.complete(2);
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), false);
+        QCOMPARE(future.result(), 2);
+    }
+
+    {
+        // Canceled if all futures are canceled
+        auto d1 = deferred<int>();
+        auto d2 = deferred<int>();
+
+        QFuture<int> future = race(QList<QFuture<int>>() << d1.future() << d2.future());
+        d1.cancel();
+        d2.cancel();
+
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), true);
+    }
+
+    {
+        // Canceling the race cancels the futures
+        auto d1 = deferred<int>();
+        auto d2 = deferred<int>();
+
+        QFuture<int> future = race(QList<QFuture<int>>() << d1.future() << d2.future());
+        future.cancel();
+
+        QVERIFY(waitUntil(d1.future(), 1000));
+        QVERIFY(waitUntil(d2.future(), 1000));
+        QCOMPARE(d1.future().isCanceled(), true);
+        QCOMPARE(d2.future().isCanceled(), true);
+    }
+
+    {
+        // Combinator in FirstCompleted mode
+        auto d1 = deferred<int>();
+        auto d2 = deferred<int>();
+
+        auto combinator = combine(FirstCompleted) << d1.future() << d2.future();
+        QFuture<void> future = combinator.future();
+        d1.complete(1);
+
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), false);
+        QVERIFY(waitUntil(d2.future(), 1000));
+        QCOMPARE(d2.future().isCanceled(), true);
+    }
+
+    {
+        QFuture<int> future = race(QList<QFuture<int>>());
+        QCOMPARE(future.isCanceled(), true);
+    }
+}
+
+void Spec::test_quorum()
+{
+    {
+        // Completed once 2 of 3 are completed. The rest is canceled.
+        auto d1 = deferred<int>();
+        auto d2 = deferred<int>();
+        auto d3 = deferred<int>();
+
+        auto combinator = quorum(2) << d1.future() << d2.future() << d3.future();
+        QFuture<void> future = combinator.future();
+
+        d1.complete(1);
+        Automator::wait(10);
+        QCOMPARE(future.isFinished(), false);
+
+        d3.complete(3);
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), false);
+
+        QVERIFY(waitUntil(d2.future(), 1000));
+        QCOMPARE(d2.future().isCanceled(), true);
+    }
+
+    {
+        // Canceled once the quorum could not be reached
+        auto d1 = deferred<int>();
+        auto d2 = deferred<int>();
+        auto d3 = deferred<int>();
+
+        auto combinator = quorum(2) << d1.future() << d2.future() << d3.future();
+        QFuture<void> future = combinator.future();
+
+        d1.cancel();
+        Automator::wait(10);
+        QCOMPARE(future.isFinished(), false);
+
+        d2.cancel();
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), true);
+
+        QVERIFY(waitUntil(d3.future(), 1000));
+        QCOMPARE(d3.future().isCanceled(), true);
+    }
+
+    {
+        // More than the number of futures
+        auto d1 = deferred<int>();
+
+        auto combinator = quorum(2) << d1.future();
+        QFuture<void> future = combinator.future();
+
+        d1.complete(1);
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), true);
+    }
+
+    {
+        // A quorum less than 1 is taken as 1, so a canceled future doesn't complete it
+        auto d1 = deferred<int>();
+        auto d2 = deferred<int>();
+
+        auto combinator = quorum(0) << d1.future() << d2.future();
+        QFuture<void> future = combinator.future();
+
+        d1.cancel();
+        Automator::wait(10);
+        QCOMPARE(future.isFinished(), false);
+
+        d2.complete(2);
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), false);
+    }
+
+    {
+        // More than the number of futures, all of them completed
+        auto d1 = deferred<int>();
+        auto d2 = deferred<int>();
+
+        auto combinator = quorum(3) << d1.future() << d2.future();
+        QFuture<void> future = combinator.future();
+
+        d1.complete(1);
+        d2.complete(2);
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), true);
+    }
+
+    {
+        // The futures added in the same pass are counted before it is decided to be impossible
+        auto d1 = deferred<int>();
+        auto d2 = deferred<int>();
+
+        d1.cancel();
+
+        Combinator combinator = quorum(1);
+        combinator << d1.future() << d2.future();
+        Automator::wait(10);
+        QCOMPARE(combinator.future().isFinished(), false);
+
+        d2.complete(2);
+        QVERIFY(waitUntil(combinator.future(), 1000));
+        QCOMPARE(combinator.future().isCanceled(), false);
+    }
+
+    {
+        // Bounded factories with a quorum
+        QSharedPointer<QAtomicInt> called(new QAtomicInt(0));
+
+        QList<std::function<QFuture<int>()>> factories;
+        for (int i = 0 ; i < 4 ; i++) {
+            factories << [=]() {
+                called->ref();
+                auto defer = deferred<int>();
+                if (i == 1) {
+                    defer.cancel();
+                } else {
+                    defer.complete(i);
+                }
+                return defer.future();
+            };
+        }
+
+        auto combinator = combine(factories, 1, Quorum, 2);
+        QFuture<void> future = combinator.future();
+
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), false);
+        QVERIFY(called->loadAcquire() >= 3);
+    }
+}
+
+void Spec::test_merge()
+{
+    {
+        // Results are added in completion order
+        auto d1 = deferred<int>();
+        auto d2 = deferred<int>();
+        auto d3 = deferred<int>();
+
+        QFuture<int> future = merge(QList<QFuture<int>>() << d1.future() << d2.future() << d3.future());
+
+        d2.complete(2);
+        QVERIFY(waitUntil([=]() {
+            return future.resultCount() == 1;
+        }, 1000));
+        QCOMPARE(future.resultAt(0), 2);
+        QCOMPARE(future.isFinished(), false);
+
+        d3.complete(QList<int>() << 3 << 4);
+        d1.complete(1);
+
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), false);
+        QCOMPARE(future.results(), QList<int>() << 2 << 3 << 4 << 1);
+    }
+
+    {
+        // Results are added in input order
+        auto d1 = deferred<int>();
+        auto d2 = deferred<int>();
+        auto d3 = deferred<int>();
+
+        QFuture<int> future = merge(QList<QFuture<int>>() << d1.future() << d2.future() << d3.future(), InputOrder);
+
+        d2.complete(2);
+        Automator::wait(10);
+        QCOMPARE(future.resultCount(), 0);
+
+        d1.complete(1);
+        QVERIFY(waitUntil([=]() {
+            return future.resultCount() == 2;
+        }, 1000));
+
+        d3.complete(3);
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.results(), QList<int>() << 1 << 2 << 3);
+    }
+
+    {
+        // Canceled once any future is canceled
+        auto d1 = deferred<int>();
+        auto d2 = deferred<int>();
+
+        QFuture<int> future = merge(QList<QFuture<int>>() << d1.future() << d2.future());
+        d1.complete(1);
+        d2.cancel();
+
+        QVERIFY(waitUntil(future, 1000));
+        QCOMPARE(future.isCanceled(), true);
+    }
+}
+
+void Spec::test_alive()
+{
+
+    {
+        auto d1 = deferred<TrackingData>();
+        auto d2 = deferred<TrackingData>();
+
+        d2.complete(d1.future());
+
+        QCOMPARE(TrackingData::aliveCount(), 0);
+
+        {
+            TrackingData dummy;
+            d1.complete(dummy);
+            QCOMPARE(TrackingData::aliveCount(), 1);
+        }
+
+        QCOMPARE(TrackingData::aliveCount(), 1);
+
+        await(d2.future());
+        Automator::wait(10);
     }
 
     Automator::wait(10);
@@ -1961,6 +3437,104 @@ void Spec::test_alive()
 
 }
 
+void Spec::test_move_result()
+{
+    {
+        // Deferred::complete(T)
+        auto defer = deferred<TrackingData>();
+        TrackingData data;
+        data.setValue(1);
+
+        TrackingData::resetCopyCount();
+        defer.complete(std::move(data));
+        QCOMPARE(TrackingData::copyCount(), 0);
+        QCOMPARE(defer.future().result().value(), 1);
+    }
+
+    {
+        // Deferred::complete(QList<T>)
+        auto defer = deferred<TrackingData>();
+        QList<TrackingData> list;
+        list << TrackingData() << TrackingData();
+
+        TrackingData::resetCopyCount();
+        defer.complete(std::move(list));
+        QCOMPARE(TrackingData::copyCount(), 0);
+        QCOMPARE(defer.future().resultCount(), 2);
+    }
+
+    {
+        // A shared list is copied, it is not modified
+        auto defer = deferred<TrackingData>();
+        QList<TrackingData> list;
+        list << TrackingData() << TrackingData();
+
+        TrackingData::resetCopyCount();
+        defer.complete(list);
+        QCOMPARE(TrackingData::copyCount(), 2);
+        QCOMPARE(list.size(), 2);
+        QCOMPARE(list[0].value(), 0);
+    }
+
+    {
+        // The return value of a callback is moved into the result store
+        auto defer = deferred<int>();
+        auto future = defer.subscribe([](int value) {
+            TrackingData data;
+            data.setValue(value);
+            return data;
+        }).future();
+
+        TrackingData::resetCopyCount();
+        defer.complete(10);
+        await(future);
+        QCOMPARE(TrackingData::copyCount(), 0);
+        QCOMPARE(future.result().value(), 10);
+    }
+
+    {
+        // In filter mode, a result moved out of order is ready once the results before it are reported
+        auto defer = Private::DeferredFuture<TrackingData>::create();
+        defer->setFilterMode(true);
+        QFuture<TrackingData> future = defer->future();
+
+        auto create = [](int value) {
+            TrackingData data;
+            data.setValue(value);
+            return data;
+        };
+
+        TrackingData::resetCopyCount();
+        defer->reportMovedResult(create(2), 1);
+        QCOMPARE(future.resultCount(), 0);
+
+        defer->reportMovedResult(create(1), 0);
+        QCOMPARE(future.resultCount(), 2);
+        QCOMPARE(TrackingData::copyCount(), 0);
+
+        defer->complete();
+        QCOMPARE(future.resultAt(0).value(), 1);
+        QCOMPARE(future.resultAt(1).value(), 2);
+    }
+
+    {
+        // The results of another future are copied only once, as they are still shared with it
+        auto source = deferred<TrackingData>();
+        QList<TrackingData> list;
+        list << TrackingData() << TrackingData() << TrackingData();
+        source.complete(std::move(list));
+
+        auto defer = Private::DeferredFuture<TrackingData>::create();
+
+        TrackingData::resetCopyCount();
+        defer->reportResultsOf(source.future());
+        QCOMPARE(TrackingData::copyCount(), 3);
+        QCOMPARE(defer->future().resultCount(), 3);
+        QCOMPARE(source.future().resultCount(), 3);
+        defer->complete();
+    }
+}
+
 void Spec::test_completed() {
     {
         auto f = AsyncFuture::completed();
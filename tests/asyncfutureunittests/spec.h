@@ -8,9 +8,14 @@ public:
     inline SignalProxy(QObject* parent = nullptr) : QObject(parent) {
     }
 
+    inline int receiverCount(const char* signal) const {
+        return receivers(signal);
+    }
+
 signals:
     void proxy0();
     void proxy1(int);
+    void proxy2(int, const QString&);
 };
 
 class Spec : public QObject
@@ -40,6 +45,8 @@ private slots:
 
     void test_private_DeferredFuture();
 
+    void test_private_ObjectPool();
+
     void test_private_run();
 
     void test_observe_future_future();
@@ -51,6 +58,10 @@ private slots:
 
     void test_Observable_context_return_future();
 
+    void test_Observable_then_executor();
+
+    void test_Observable_observer_thread_finished();
+
     void test_Observable_signal();
     void test_Observable_signal_with_argument();
 
@@ -59,10 +70,26 @@ private slots:
 
     void test_Observable_signal_destroyed();
 
+    void test_Observable_signal_direct();
+
+    void test_Observable_signal_arguments();
+
+    void test_Observable_signal_shared();
+
+    void test_stream();
+
     void test_Observable_subscribe();
 
     void test_Observable_subscribe_in_thread();
 
+    void test_Observable_subscribe_thread_finished();
+
+    void test_Observable_subscribe_multiple_observers();
+
+    void test_Observable_inlineIfReady();
+
+    void test_Observable_subscribe_allocation();
+
     void test_Observable_subscribe_return_future();
 
     void test_Observable_subscribe_return_canceledFuture();
@@ -103,6 +130,10 @@ private slots:
 
     void test_Deferred_setProgress();
 
+    void test_Deferred_coalesceProgress();
+
+    void test_Deferred_complete_race();
+
     void test_Deferred_reportStarted();
 
     void test_Combinator();
@@ -111,8 +142,28 @@ private slots:
 
     void test_Combinator_progressValue();
 
+    void test_Combinator_progress_weight();
+
+    void test_Combinator_shard();
+
+    void test_Combinator_parallelCancel();
+
+    void test_Combinator_factories();
+
+    void test_all();
+
+    void test_all_tuple();
+
+    void test_race();
+
+    void test_quorum();
+
+    void test_merge();
+
     void test_alive();
 
+    void test_move_result();
+
     void test_completed();
     void test_Combinator_add_to_already_finished_finished();
     void test_observe_future_future_completed();
@@ -2,6 +2,7 @@
 
 
 static int s_livingCount = 0;
+static int s_copyCount = 0;
 
 class TrackingDataPriv : public QSharedData
 {
@@ -25,14 +26,28 @@ TrackingData::TrackingData() : data(new TrackingDataPriv)
 }
 
 TrackingData::TrackingData(const TrackingData &rhs) : data(rhs.data)
+{
+    s_copyCount++;
+}
+
+TrackingData::TrackingData(TrackingData &&rhs) : data(std::move(rhs.data))
 {
 
 }
 
 TrackingData &TrackingData::operator=(const TrackingData &rhs)
 {
-    if (this != &rhs)
+    if (this != &rhs) {
         data.operator=(rhs.data);
+        s_copyCount++;
+    }
+    return *this;
+}
+
+TrackingData &TrackingData::operator=(TrackingData &&rhs)
+{
+    if (this != &rhs)
+        data.operator=(std::move(rhs.data));
     return *this;
 }
 
@@ -46,6 +61,16 @@ int TrackingData::aliveCount()
     return s_livingCount;
 }
 
+int TrackingData::copyCount()
+{
+    return s_copyCount;
+}
+
+void TrackingData::resetCopyCount()
+{
+    s_copyCount = 0;
+}
+
 int TrackingData::value() const
 {
     return data->value;
@@ -10,11 +10,17 @@ class TrackingData
 public:
     TrackingData();
     TrackingData(const TrackingData &);
+    TrackingData(TrackingData &&);
     TrackingData &operator=(const TrackingData &);
+    TrackingData &operator=(TrackingData &&);
     ~TrackingData();
 
     static int aliveCount();
 
+    // No. of copy constructions and copy assignments
+    static int copyCount();
+    static void resetCopyCount();
+
     int value() const;
     void setValue(int value);
 